@@ -21,6 +21,7 @@
 #include <rmf_traffic/Trajectory.hpp>
 #include <rmf_traffic/Profile.hpp>
 #include <exception>
+#include <vector>
 
 namespace rmf_traffic {
 
@@ -58,6 +59,36 @@ public:
     const Trajectory& trajectory_b,
     Interpolate interpolation = Interpolate::CubicSpline);
 
+  /// A profile and trajectory that can be checked by between_many(). The
+  /// profile and trajectory must outlive the call to between_many().
+  struct Other
+  {
+    const Profile* profile;
+    const Trajectory* trajectory;
+  };
+
+  /// The first conflict that was found by between_many()
+  struct Conflict
+  {
+    /// The index of the element in the `others` argument that is in conflict
+    std::size_t index;
+
+    /// The time at which the conflict happens
+    Time time;
+  };
+
+  /// Checks one trajectory against many others. This gives the same result as
+  /// calling between() for each element of `others` in order, but the work
+  /// that only depends on `profile` and `trajectory` is done just once.
+  ///
+  /// \return information about the first element of `others` that has a
+  /// conflict with the trajectory, or a nullopt if none of them do.
+  static rmf_utils::optional<Conflict> between_many(
+    const Profile& profile,
+    const Trajectory& trajectory,
+    const std::vector<Other>& others,
+    Interpolate interpolation = Interpolate::CubicSpline);
+
   class Implementation;
 };
 
@@ -129,8 +129,9 @@ public:
   private:
 
     /// \internal Private constructor. Use Trajectory::insert() to create
-    /// a new Trajectory Waypoint.
-    Waypoint();
+    /// a new Trajectory Waypoint. The implementation is owned by the
+    /// Trajectory that the Waypoint belongs to.
+    Waypoint(Implementation* impl);
     Waypoint(const Waypoint&) = delete;
     Waypoint(Waypoint&&) = default;
     Waypoint& operator=(const Waypoint&) = delete;
@@ -27,6 +27,8 @@
 
 #include <rmf_utils/optional.hpp>
 
+#include <iosfwd>
+
 namespace rmf_traffic {
 namespace agv {
 
@@ -88,6 +90,21 @@ public:
     /// Get a const reference to the interpolation options
     const Interpolate::Options& interpolation() const;
 
+    /// Choose whether the Planner should compute its heuristic tables for
+    /// every goal waypoint of the graph when it is constructed. This makes
+    /// the first plan towards each goal as fast as later ones, at the cost of
+    /// a slower construction. The tables can be saved with
+    /// Planner::save_heuristics() and reloaded with
+    /// Planner::load_heuristics() to skip that work on the next startup.
+    ///
+    /// This is false by default, in which case the table for a goal is
+    /// computed the first time a plan is requested for it.
+    Configuration& precompute_heuristics(bool precompute);
+
+    /// Check whether the heuristic tables will be computed for every goal
+    /// waypoint when the Planner is constructed.
+    bool precompute_heuristics() const;
+
     // TODO(MXG): Add a field to specify whether multi-start planning problems
     // should choose the plan that takes the least amount of time (according to
     // plan duration) or the plan that finishes the earliest (according to the
@@ -310,6 +327,30 @@ public:
   /// Get a const reference to the default planning options.
   const Options& get_default_options() const;
 
+  /// Write the heuristic tables that this Planner has computed so far to a
+  /// binary stream. The output can only be loaded by a Planner whose
+  /// Configuration is the same as this one's.
+  ///
+  /// \param[in] output
+  ///   The stream to write to. It should be opened in binary mode.
+  void save_heuristics(std::ostream& output) const;
+
+  /// Load heuristic tables that were written by save_heuristics(). Tables
+  /// that the Planner has already computed for the same goals are replaced.
+  ///
+  /// The input records a fingerprint of the waypoint locations, the lanes and
+  /// their event durations, and the linear traits of the vehicle. It will only
+  /// be accepted if all of those match this Planner's Configuration.
+  ///
+  /// \param[in] input
+  ///   The stream to read from. It should be opened in binary mode.
+  ///
+  /// \throws std::invalid_argument if the input is not a valid set of tables,
+  /// was written in an unsupported format version, or was computed for a
+  /// different graph or different vehicle traits. The Planner is not modified
+  /// in that case.
+  Planner& load_heuristics(std::istream& input);
+
   using StartSet = std::vector<Start>;
 
   /// Produce a plan for the given starting conditions and goal. The default
@@ -130,6 +130,11 @@ public:
     Goal goal,
     Options options) const;
 
+  /// Get the number of search nodes that were dropped while producing this
+  /// result because an equivalent state had already been expanded at an
+  /// earlier time and a lower cost.
+  static std::size_t pruned_node_count(const Planner::Result& result);
+
   class Implementation;
 private:
   rmf_utils::impl_ptr<Implementation> _pimpl;
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TRAFFIC__SCHEDULE__BUCKETPOLICY_HPP
+#define RMF_TRAFFIC__SCHEDULE__BUCKETPOLICY_HPP
+
+#include <rmf_traffic/Time.hpp>
+
+#include <rmf_utils/impl_ptr.hpp>
+
+namespace rmf_traffic {
+namespace schedule {
+
+//==============================================================================
+/// The schedule database and its mirrors sort their routes into time buckets so
+/// that queries only need to look at routes which are active around the times
+/// that they care about. This class describes how the time buckets should be
+/// laid out.
+///
+/// By default every bucket spans a fixed duration. In adaptive mode, a bucket
+/// that collects more than split_threshold() routes will be split in half
+/// (down to a minimum of min_bucket_duration()), and neighboring buckets that
+/// collectively hold fewer than merge_threshold() routes will be merged back
+/// together (up to a maximum of max_bucket_duration()) whenever the schedule
+/// gets culled. Adaptive mode will also use wider buckets to cover quiet
+/// stretches of time that have no routes in them.
+class BucketPolicy
+{
+public:
+
+  /// Constructor
+  ///
+  /// \param[in] bucket_duration
+  ///   The nominal duration of each bucket.
+  ///
+  /// \param[in] adaptive
+  ///   True if the buckets should be split and merged based on how many routes
+  ///   they are holding.
+  ///
+  /// \throws std::invalid_argument if bucket_duration is not positive.
+  BucketPolicy(
+    Duration bucket_duration = std::chrono::minutes(1),
+    bool adaptive = false);
+
+  /// Set the nominal duration of each bucket.
+  ///
+  /// \throws std::invalid_argument if duration is not positive.
+  BucketPolicy& bucket_duration(Duration duration);
+
+  /// Get the nominal duration of each bucket.
+  Duration bucket_duration() const;
+
+  /// Set whether the buckets should be adaptive.
+  BucketPolicy& adaptive(bool on);
+
+  /// Get whether the buckets are adaptive.
+  bool adaptive() const;
+
+  /// Set how many routes a bucket may hold before it gets split in half. This
+  /// is only used in adaptive mode.
+  ///
+  /// \throws std::invalid_argument if count is not greater than the current
+  /// merge_threshold(). When lowering both thresholds, set the
+  /// merge_threshold() first.
+  BucketPolicy& split_threshold(std::size_t count);
+
+  /// Get how many routes a bucket may hold before it gets split in half.
+  std::size_t split_threshold() const;
+
+  /// Set the number of routes that two neighboring buckets must collectively
+  /// hold fewer than in order to be merged together. This should be
+  /// considerably smaller than the split_threshold() to avoid repeatedly
+  /// splitting and merging the same buckets. This is only used in adaptive
+  /// mode.
+  ///
+  /// \throws std::invalid_argument if count is not smaller than the current
+  /// split_threshold().
+  BucketPolicy& merge_threshold(std::size_t count);
+
+  /// Get the number of routes that two neighboring buckets must collectively
+  /// hold fewer than in order to be merged together.
+  std::size_t merge_threshold() const;
+
+  /// Set the shortest duration that a bucket can be split down to.
+  ///
+  /// \throws std::invalid_argument if duration is not positive or if it is
+  /// greater than the current max_bucket_duration().
+  BucketPolicy& min_bucket_duration(Duration duration);
+
+  /// Get the shortest duration that a bucket can be split down to.
+  Duration min_bucket_duration() const;
+
+  /// Set the longest duration that buckets can be merged up to.
+  ///
+  /// \throws std::invalid_argument if duration is not positive or if it is
+  /// less than the current min_bucket_duration().
+  BucketPolicy& max_bucket_duration(Duration duration);
+
+  /// Get the longest duration that buckets can be merged up to.
+  Duration max_bucket_duration() const;
+
+  class Implementation;
+private:
+  rmf_utils::impl_ptr<Implementation> _pimpl;
+};
+
+} // namespace schedule
+} // namespace rmf_traffic
+
+#endif // RMF_TRAFFIC__SCHEDULE__BUCKETPOLICY_HPP
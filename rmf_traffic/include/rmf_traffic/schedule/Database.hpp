@@ -18,6 +18,7 @@
 #ifndef RMF_TRAFFIC__SCHEDULE__DATABASE_HPP
 #define RMF_TRAFFIC__SCHEDULE__DATABASE_HPP
 
+#include <rmf_traffic/schedule/BucketPolicy.hpp>
 #include <rmf_traffic/schedule/Inconsistencies.hpp>
 #include <rmf_traffic/schedule/Viewer.hpp>
 #include <rmf_traffic/schedule/Patch.hpp>
@@ -105,6 +106,27 @@ public:
     const Query::Spacetime& spacetime,
     const Query::Participants& participants) const final;
 
+  // Documentation inherited from Viewer
+  View query(
+    const std::string& map,
+    Time lower_time_bound,
+    Time upper_time_bound,
+    const Query::Participants& participants) const final;
+
+  // Documentation inherited from Viewer
+  bool visit(
+    const Query::Spacetime& spacetime,
+    const Query::Participants& participants,
+    const Visitor& visitor) const final;
+
+  // Documentation inherited from Viewer
+  bool visit(
+    const std::string& map,
+    Time lower_time_bound,
+    Time upper_time_bound,
+    const Query::Participants& participants,
+    const Visitor& visitor) const final;
+
   // Documentation inherited from Viewer
   const std::unordered_set<ParticipantId>& participant_ids() const final;
 
@@ -132,7 +154,11 @@ public:
   //============================================================================
 
   /// Initialize a Database
-  Database();
+  ///
+  /// \param[in] bucket_policy
+  ///   Describes how the routes of the schedule should be sorted into time
+  ///   buckets for the sake of querying them.
+  Database(const BucketPolicy& bucket_policy = BucketPolicy());
 
   /// A description of all inconsistencies currently present in the database.
   /// Inconsistencies are isolated between Participants.
@@ -202,6 +228,27 @@ public:
   /// call this function for any other purpose.
   void set_current_time(Time time);
 
+  /// Set how many versions of the schedule the database should keep a record
+  /// of changed routes for. When changes() is asked for a patch after a
+  /// version that is still within this horizon, only the routes that changed
+  /// since then will be inspected. Otherwise the whole schedule will be
+  /// searched. Setting this to zero disables the record.
+  ///
+  /// The default horizon is 1000 versions.
+  void set_change_log_horizon(std::size_t versions);
+
+  /// Get the current horizon of the change log.
+  std::size_t get_change_log_horizon() const;
+
+  /// Set how many threads may share the work of a large region query, either
+  /// from query() or from changes(). Queries that are too small to benefit
+  /// from this will still run on the calling thread. The default is 1, which
+  /// means every query runs on the calling thread.
+  void set_query_workers(std::size_t workers);
+
+  /// Get the number of threads that may share the work of a query.
+  std::size_t get_query_workers() const;
+
   /// Get the curret itinerary version for the specified participant.
   //
   // TODO(MXG): This function needs unit testing
@@ -46,6 +46,27 @@ public:
     const Query::Spacetime& spacetime,
     const Query::Participants& participants) const final;
 
+  // Documentation inherited from Viewer
+  View query(
+    const std::string& map,
+    Time lower_time_bound,
+    Time upper_time_bound,
+    const Query::Participants& participants) const final;
+
+  // Documentation inherited from Viewer
+  bool visit(
+    const Query::Spacetime& spacetime,
+    const Query::Participants& participants,
+    const Visitor& visitor) const final;
+
+  // Documentation inherited from Viewer
+  bool visit(
+    const std::string& map,
+    Time lower_time_bound,
+    Time upper_time_bound,
+    const Query::Participants& participants,
+    const Visitor& visitor) const final;
+
   // Documentation inherited from Viewer
   const std::unordered_set<ParticipantId>& participant_ids() const final;
 
@@ -72,7 +93,11 @@ public:
   //============================================================================
 
   /// Create a database mirror
-  Mirror();
+  ///
+  /// \param[in] bucket_policy
+  ///   Describes how the routes of the mirror should be sorted into time
+  ///   buckets for the sake of querying them.
+  Mirror(const BucketPolicy& bucket_policy = BucketPolicy());
 
   /// Update this mirror.
   ///
@@ -158,6 +158,16 @@ public:
         const Query::Spacetime& parameters,
         const VersionedKeySequence& alternatives) const;
 
+      /// View the routes in this table that are on the given map and active
+      /// at some point between the time bounds. This gives the same View as a
+      /// Timespan query for that single map, without needing to construct a
+      /// Query::Spacetime.
+      View query(
+        const std::string& map,
+        Time lower_time_bound,
+        Time upper_time_bound,
+        const VersionedKeySequence& alternatives) const;
+
       using AlternativeMap =
         std::unordered_map<ParticipantId, std::shared_ptr<Alternatives>>;
 
@@ -28,6 +28,8 @@
 #include <rmf_utils/macros.hpp>
 #include <rmf_utils/optional.hpp>
 
+#include <functional>
+
 namespace rmf_traffic {
 namespace schedule {
 
@@ -91,6 +93,52 @@ public:
     const Query::Spacetime& spacetime,
     const Query::Participants& participants) const = 0;
 
+  /// Query this Viewer for the routes on one map that are active at some point
+  /// between the lower and upper time bounds. This gives the same View as a
+  /// Timespan query for that single map, but it does not need a
+  /// Query::Spacetime to be constructed, so it is cheaper to call at a high
+  /// frequency, e.g. while validating the routes of a planner.
+  ///
+  /// The default implementation builds the Timespan query and forwards it to
+  /// query(spacetime, participants), so it is only cheaper for viewers that
+  /// override it.
+  virtual View query(
+    const std::string& map,
+    Time lower_time_bound,
+    Time upper_time_bound,
+    const Query::Participants& participants) const;
+
+  /// A callback that is given each route found by visit(). It should return
+  /// true to keep visiting routes, or false to stop the search early.
+  using Visitor = std::function<bool(const View::Element& element)>;
+
+  /// Visit the routes that match the query parameters, in the same way that
+  /// query() would find them, but without collecting them into a View first.
+  /// Each route is given to the visitor as soon as it is found, and the search
+  /// stops as soon as the visitor returns false, so this is much cheaper than
+  /// query() when only the first few routes are needed.
+  ///
+  /// The references inside of each Element are only guaranteed to remain
+  /// valid until visit() returns.
+  ///
+  /// The default implementation collects the results of query() into a View
+  /// and then visits them, so it is only cheaper for viewers that override it.
+  ///
+  /// \return false if the visitor stopped the search early, otherwise true.
+  virtual bool visit(
+    const Query::Spacetime& spacetime,
+    const Query::Participants& participants,
+    const Visitor& visitor) const;
+
+  /// Alternative signature for visit() which matches the single map timespan
+  /// signature of query()
+  virtual bool visit(
+    const std::string& map,
+    Time lower_time_bound,
+    Time upper_time_bound,
+    const Query::Participants& participants,
+    const Visitor& visitor) const;
+
   // TODO(MXG): Consider providing an iterator-style API to view participant IDs
   // and participant descriptions.
 
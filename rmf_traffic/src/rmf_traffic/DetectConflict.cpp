@@ -27,6 +27,9 @@
 #include <fcl/ccd/motion.h>
 #include <fcl/collision.h>
 
+#include <rmf_traffic/geometry/Circle.hpp>
+
+#include <array>
 #include <unordered_map>
 
 namespace rmf_traffic {
@@ -122,48 +125,10 @@ bool have_time_overlap(
 }
 
 //==============================================================================
-std::tuple<Trajectory::const_iterator, Trajectory::const_iterator>
-get_initial_iterators(
-  const Trajectory& trajectory_a,
-  const Trajectory& trajectory_b)
-{
-  const Time& t_a0 = *trajectory_a.start_time();
-  const Time& t_b0 = *trajectory_b.start_time();
-
-  Trajectory::const_iterator a_it;
-  Trajectory::const_iterator b_it;
-
-  if (t_a0 < t_b0)
-  {
-    // Trajectory `a` starts first, so we begin evaluating at the time
-    // that `b` begins
-    a_it = trajectory_a.find(t_b0);
-    b_it = ++trajectory_b.begin();
-  }
-  else if (t_b0 < t_a0)
-  {
-    // Trajectory `b` starts first, so we begin evaluating at the time
-    // that `a` begins
-    a_it = ++trajectory_a.begin();
-    b_it = trajectory_b.find(t_a0);
-  }
-  else
-  {
-    // The Trajectories begin at the exact same time, so both will begin
-    // from their start
-    a_it = ++trajectory_a.begin();
-    b_it = ++trajectory_b.begin();
-  }
-
-  return {a_it, b_it};
-}
-
-//==============================================================================
-struct BoundingBox
-{
-  Eigen::Vector2d min;
-  Eigen::Vector2d max;
-};
+using internal::BoundingBox;
+using internal::adjust_bounding_box;
+using internal::overlap;
+using internal::void_box;
 
 //==============================================================================
 struct BoundingProfile
@@ -254,29 +219,6 @@ BoundingBox get_bounding_box(const rmf_traffic::Spline& spline)
   };
 }
 
-//==============================================================================
-/// Create a bounding box which will never overlap with any other BoundingBox
-BoundingBox void_box()
-{
-  constexpr double inf = std::numeric_limits<double>::infinity();
-  return BoundingBox{
-    Eigen::Vector2d{inf, inf},
-    Eigen::Vector2d{-inf, -inf}
-  };
-}
-
-//==============================================================================
-BoundingBox adjust_bounding_box(
-  const BoundingBox& input,
-  const double value)
-{
-  BoundingBox box = input;
-  box.min -= Eigen::Vector2d{value, value};
-  box.max += Eigen::Vector2d{value, value};
-
-  return box;
-}
-
 //==============================================================================
 BoundingBox get_bounding_footprint(
   const rmf_traffic::Spline& spline,
@@ -313,20 +255,92 @@ BoundingProfile get_bounding_profile(
 }
 
 //==============================================================================
-bool overlap(
-  const BoundingBox& box_a,
-  const BoundingBox& box_b)
+/// Add the node that covers the segments [begin, end) to the hierarchy of the
+/// cache, along with all the nodes below it.
+std::size_t build_segment_tree(
+  internal::SegmentCache& cache,
+  const std::size_t begin,
+  const std::size_t end)
 {
-  for (int i = 0; i < 2; ++i)
+  auto& nodes = cache.nodes;
+  const std::size_t index = nodes.size();
+  nodes.push_back(
+    internal::SegmentCache::Node{
+      begin, end,
+      cache.splines[begin].start_time(), cache.splines[end-1].finish_time(),
+      cache.boxes[begin],
+      0, 0
+    });
+
+  if (end - begin == 1)
+    return index;
+
+  const std::size_t mid = begin + (end - begin)/2;
+  const std::size_t left = build_segment_tree(cache, begin, mid);
+  const std::size_t right = build_segment_tree(cache, mid, end);
+
+  auto& node = nodes[index];
+  node.left = left;
+  node.right = right;
+  node.box.min = nodes[left].box.min.cwiseMin(nodes[right].box.min);
+  node.box.max = nodes[left].box.max.cwiseMax(nodes[right].box.max);
+
+  return index;
+}
+
+//==============================================================================
+using SegmentPair = std::pair<std::size_t, std::size_t>;
+
+//==============================================================================
+/// Find the pairs of segments whose boxes come within a certain distance of
+/// each other while their times overlap.
+void collect_segment_pairs(
+  const internal::SegmentCache& tree_a,
+  const std::size_t index_a,
+  const internal::SegmentCache& tree_b,
+  const std::size_t index_b,
+  const double distance,
+  std::vector<SegmentPair>& output,
+  DetectConflict::Implementation::Statistics* statistics)
+{
+  const internal::SegmentCache::Node& node_a = tree_a.nodes[index_a];
+  const internal::SegmentCache::Node& node_b = tree_b.nodes[index_b];
+
+  if (node_a.finish_time < node_b.start_time
+    || node_b.finish_time < node_a.start_time)
+    return;
+
+  if (!overlap(node_a.box, adjust_bounding_box(node_b.box, distance)))
   {
-    if (box_a.max[i] < box_b.min[i])
-      return false;
+    if (statistics)
+      ++statistics->segment_run_pairs_pruned;
 
-    if (box_b.max[i] < box_a.min[i])
-      return false;
+    return;
   }
 
-  return true;
+  if (node_a.leaf() && node_b.leaf())
+  {
+    output.emplace_back(node_a.begin, node_b.begin);
+    return;
+  }
+
+  // Descend into whichever node covers more segments
+  if (node_b.leaf()
+    || (!node_a.leaf()
+    && node_b.end - node_b.begin <= node_a.end - node_a.begin))
+  {
+    collect_segment_pairs(
+      tree_a, node_a.left, tree_b, index_b, distance, output, statistics);
+    collect_segment_pairs(
+      tree_a, node_a.right, tree_b, index_b, distance, output, statistics);
+  }
+  else
+  {
+    collect_segment_pairs(
+      tree_a, index_a, tree_b, node_b.left, distance, output, statistics);
+    collect_segment_pairs(
+      tree_a, index_a, tree_b, node_b.right, distance, output, statistics);
+  }
 }
 
 //==============================================================================
@@ -380,6 +394,205 @@ rmf_utils::optional<fcl::FCL_REAL> check_collision(
   return rmf_utils::nullopt;
 }
 
+//==============================================================================
+/// Get the radius of a shape if it is a circle
+rmf_utils::optional<double> get_circle_radius(
+  const geometry::ConstFinalConvexShapePtr& shape)
+{
+  if (!shape)
+    return rmf_utils::nullopt;
+
+  const auto* circle = dynamic_cast<const geometry::Circle*>(&shape->source());
+  if (!circle)
+    return rmf_utils::nullopt;
+
+  return circle->get_radius();
+}
+
+//==============================================================================
+/// A polynomial of degree N with its coefficients ordered from the constant
+/// term to the highest degree term
+template<std::size_t N>
+using Polynomial = std::array<double, N+1>;
+
+//==============================================================================
+template<std::size_t N>
+double evaluate(const Polynomial<N>& p, const double s)
+{
+  double result = p[N];
+  for (std::size_t i = N; i > 0; --i)
+    result = result*s + p[i-1];
+
+  return result;
+}
+
+//==============================================================================
+/// Find the value in [lower, upper] where a monotonic polynomial crosses zero
+template<std::size_t N>
+double bisect(const Polynomial<N>& p, double lower, double upper)
+{
+  const bool rising = evaluate<N>(p, lower) < evaluate<N>(p, upper);
+
+  // 50 iterations will narrow the range to within machine precision
+  for (std::size_t i = 0; i < 50; ++i)
+  {
+    const double mid = (lower + upper)/2.0;
+    if ((evaluate<N>(p, mid) < 0.0) == rising)
+      lower = mid;
+    else
+      upper = mid;
+  }
+
+  return upper;
+}
+
+//==============================================================================
+/// Find the roots of a polynomial within (lower, upper). The roots of its
+/// derivative divide the range into intervals where the polynomial is
+/// monotonic, and each of those intervals can contain at most one root.
+template<std::size_t N>
+struct RootFinder
+{
+  static std::size_t find(
+    const Polynomial<N>& p,
+    const double lower,
+    const double upper,
+    std::array<double, N>& roots)
+  {
+    Polynomial<N-1> derivative;
+    for (std::size_t i = 0; i < N; ++i)
+      derivative[i] = static_cast<double>(i+1) * p[i+1];
+
+    std::array<double, N+1> bounds;
+    bounds[0] = lower;
+    std::array<double, N-1> critical;
+    const std::size_t num_critical =
+      RootFinder<N-1>::find(derivative, lower, upper, critical);
+    for (std::size_t i = 0; i < num_critical; ++i)
+      bounds[i+1] = critical[i];
+    bounds[num_critical+1] = upper;
+
+    std::size_t num_roots = 0;
+    for (std::size_t i = 0; i <= num_critical; ++i)
+    {
+      const double f_0 = evaluate<N>(p, bounds[i]);
+      const double f_1 = evaluate<N>(p, bounds[i+1]);
+      if (f_0 == 0.0)
+      {
+        if (i > 0)
+          roots[num_roots++] = bounds[i];
+      }
+      else if ((f_0 < 0.0) != (f_1 < 0.0) && f_1 != 0.0)
+      {
+        roots[num_roots++] = bisect<N>(p, bounds[i], bounds[i+1]);
+      }
+    }
+
+    return num_roots;
+  }
+};
+
+//==============================================================================
+template<>
+struct RootFinder<1>
+{
+  static std::size_t find(
+    const Polynomial<1>& p,
+    const double lower,
+    const double upper,
+    std::array<double, 1>& roots)
+  {
+    if (p[1] == 0.0)
+      return 0;
+
+    const double root = -p[0]/p[1];
+    if (root <= lower || upper <= root)
+      return 0;
+
+    roots[0] = root;
+    return 1;
+  }
+};
+
+//==============================================================================
+/// Get the coefficients of the x and y motion of a spline between start_time
+/// and finish_time, where the time is scaled to the range [0, 1].
+std::array<Polynomial<3>, 2> get_planar_coefficients(
+  const Spline& spline,
+  const Time start_time,
+  const Time finish_time)
+{
+  const double dt = time::to_seconds(finish_time - start_time);
+  const Eigen::Vector2d x0 = spline.compute_position(start_time).head<2>();
+  const Eigen::Vector2d x1 = spline.compute_position(finish_time).head<2>();
+  const Eigen::Vector2d v0 =
+    dt * spline.compute_velocity(start_time).head<2>();
+  const Eigen::Vector2d v1 =
+    dt * spline.compute_velocity(finish_time).head<2>();
+
+  std::array<Polynomial<3>, 2> result;
+  for (int i = 0; i < 2; ++i)
+  {
+    result[i] = {
+      x0[i],
+      v0[i],
+      3.0*(x1[i] - x0[i]) - 2.0*v0[i] - v1[i],
+      2.0*(x0[i] - x1[i]) + v0[i] + v1[i]
+    };
+  }
+
+  return result;
+}
+
+//==============================================================================
+/// Find the earliest moment that two circles moving along splines come into
+/// contact. The squared distance between the centers is a polynomial of
+/// degree 6 in time, so the moment of contact can be found directly instead of
+/// relying on conservative advancement.
+rmf_utils::optional<double> check_circle_collision(
+  const Spline& spline_a,
+  const double radius_a,
+  const Spline& spline_b,
+  const double radius_b,
+  const Time start_time,
+  const Time finish_time)
+{
+  const auto coeffs_a = get_planar_coefficients(
+    spline_a, start_time, finish_time);
+  const auto coeffs_b = get_planar_coefficients(
+    spline_b, start_time, finish_time);
+
+  // f(s) = |a(s) - b(s)|^2 - (r_a + r_b)^2
+  const double contact = radius_a + radius_b;
+  Polynomial<6> f = {};
+  f[0] = -contact*contact;
+  for (std::size_t k = 0; k < 2; ++k)
+  {
+    Polynomial<3> d;
+    for (std::size_t i = 0; i < 4; ++i)
+      d[i] = coeffs_a[k][i] - coeffs_b[k][i];
+
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+      for (std::size_t j = 0; j < 4; ++j)
+        f[i+j] += d[i]*d[j];
+    }
+  }
+
+  if (evaluate<6>(f, 0.0) <= 0.0)
+    return 0.0;
+
+  std::array<double, 6> roots;
+  const std::size_t num_roots = RootFinder<6>::find(f, 0.0, 1.0, roots);
+  if (num_roots > 0)
+    return roots[0];
+
+  if (evaluate<6>(f, 1.0) <= 0.0)
+    return 1.0;
+
+  return rmf_utils::nullopt;
+}
+
 //==============================================================================
 Profile::Implementation convert_profile(const Profile& profile)
 {
@@ -431,9 +644,9 @@ fcl::Transform3f convert(Eigen::Vector3d p)
 //==============================================================================
 bool close_start(
   const Profile::Implementation& profile_a,
-  const Trajectory::const_iterator& a_it,
+  const Spline& spline_a,
   const Profile::Implementation& profile_b,
-  const Trajectory::const_iterator& b_it)
+  const Spline& spline_b)
 {
   // If two trajectories start very close to each other, then we do not consider
   // it a conflict for them to be in each other's vicinities. This gives robots
@@ -448,8 +661,6 @@ bool close_start(
     return false;
   }
 
-  Spline spline_a(a_it);
-  Spline spline_b(b_it);
   const auto start_time =
     std::max(spline_a.start_time(), spline_b.start_time());
 
@@ -478,16 +689,40 @@ bool close_start(
   return false;
 }
 
-} // anonymous namespace
+//==============================================================================
+/// The parts of a conflict check that only depend on one of the trajectories.
+/// These can be reused when one trajectory gets checked against many others.
+struct PreparedTrajectory
+{
+  PreparedTrajectory(
+    Profile::Implementation profile_,
+    const Trajectory& trajectory_)
+  : profile(std::move(profile_)),
+    trajectory(trajectory_),
+    segments(internal::get_segment_cache(trajectory_)),
+    footprint_radius(get_circle_radius(profile.footprint)),
+    vicinity_radius(get_circle_radius(profile.vicinity))
+  {
+    // Do nothing
+  }
+
+  Profile::Implementation profile;
+  const Trajectory& trajectory;
+
+  // The splines and the box hierarchy are only built once for each
+  // trajectory, so preparing one that was checked before allocates nothing.
+  std::shared_ptr<const internal::SegmentCache> segments;
+
+  // Circles can be checked analytically, so FCL will only be used when one of
+  // the shapes in a check is something else.
+  rmf_utils::optional<double> footprint_radius;
+  rmf_utils::optional<double> vicinity_radius;
+};
 
 //==============================================================================
-rmf_utils::optional<rmf_traffic::Time> DetectConflict::Implementation::between(
-  const Profile& input_profile_a,
+void check_segment_count(
   const Trajectory& trajectory_a,
-  const Profile& input_profile_b,
-  const Trajectory& trajectory_b,
-  Interpolate /*interpolation*/,
-  std::vector<Conflict>* output_conflicts)
+  const Trajectory& trajectory_b)
 {
   const std::size_t min_size =
     std::min(trajectory_a.size(), trajectory_b.size());
@@ -496,14 +731,19 @@ rmf_utils::optional<rmf_traffic::Time> DetectConflict::Implementation::between(
     throw invalid_trajectory_error::Implementation
           ::make_segment_num_error(min_size);
   }
+}
 
-  const Profile::Implementation profile_a = convert_profile(input_profile_a);
-  const Profile::Implementation profile_b = convert_profile(input_profile_b);
-
+//==============================================================================
+bool may_conflict(
+  const Profile::Implementation& profile_a,
+  const Trajectory& trajectory_a,
+  const Profile::Implementation& profile_b,
+  const Trajectory& trajectory_b)
+{
   // Return early if there is no geometry in the profiles
   // TODO(MXG): Should this produce an exception? Is this an okay scenario?
   if (!profile_a.footprint && !profile_b.footprint)
-    return rmf_utils::nullopt;
+    return false;
 
   // Return early if either profile is missing both a vicinity and a footprint.
   // NOTE(MXG): Since convert_profile will promote the vicinity to have the same
@@ -511,29 +751,45 @@ rmf_utils::optional<rmf_traffic::Time> DetectConflict::Implementation::between(
   // a vicinity doesn't exist is the same as checking that both the vicinity and
   // footprint doesn't exist.
   if (!profile_a.vicinity || !profile_b.vicinity)
-    return rmf_utils::nullopt;
+    return false;
 
   // Return early if there is no time overlap between the trajectories
   if (!have_time_overlap(trajectory_a, trajectory_b))
-    return rmf_utils::nullopt;
-
-  Trajectory::const_iterator a_it;
-  Trajectory::const_iterator b_it;
-  std::tie(a_it, b_it) = get_initial_iterators(trajectory_a, trajectory_b);
-
-  rmf_utils::optional<Spline> spline_a;
-  rmf_utils::optional<Spline> spline_b;
+    return false;
 
-  std::shared_ptr<fcl::SplineMotion> motion_a =
-    make_uninitialized_fcl_spline_motion();
-  std::shared_ptr<fcl::SplineMotion> motion_b =
-    make_uninitialized_fcl_spline_motion();
+  return true;
+}
 
-  const fcl::ContinuousCollisionRequest request = make_fcl_request();
+//==============================================================================
+rmf_utils::optional<rmf_traffic::Time> between_prepared(
+  const PreparedTrajectory& prepared_a,
+  const PreparedTrajectory& prepared_b,
+  std::vector<DetectConflict::Implementation::Conflict>* output_conflicts,
+  DetectConflict::Implementation::Statistics* statistics)
+{
+  using Conflict = DetectConflict::Implementation::Conflict;
+  const Profile::Implementation& profile_a = prepared_a.profile;
+  const Profile::Implementation& profile_b = prepared_b.profile;
+  const Trajectory& trajectory_a = prepared_a.trajectory;
+  const Trajectory& trajectory_b = prepared_b.trajectory;
+  const internal::SegmentCache& tree_a = *prepared_a.segments;
+  const internal::SegmentCache& tree_b = *prepared_b.segments;
+
+  // Begin at the segments which are active when the later trajectory starts
+  std::size_t initial_a = 0;
+  std::size_t initial_b = 0;
+  const Time& t_a0 = *trajectory_a.start_time();
+  const Time& t_b0 = *trajectory_b.start_time();
+  if (t_a0 < t_b0)
+    initial_a = tree_a.find(t_b0);
+  else if (t_b0 < t_a0)
+    initial_b = tree_b.find(t_a0);
 
   // This flag lets us know that only a collision between the footprints of the
   // vehicles will count as a conflict.
-  const bool test_footprints = close_start(profile_a, a_it, profile_b, b_it);
+  const bool test_footprints = close_start(
+    profile_a, tree_a.splines[initial_a],
+    profile_b, tree_b.splines[initial_b]);
 
   // This flag lets us know that we need to test both a's footprint in b's
   // vicinity and b's footprint in a's vicinity.
@@ -541,97 +797,194 @@ rmf_utils::optional<rmf_traffic::Time> DetectConflict::Implementation::between(
     (profile_a.vicinity != profile_a.footprint)
     || (profile_b.vicinity != profile_b.footprint);
 
+  // The boxes of the segment trees only follow the center of each trajectory,
+  // so we need to know how close the centers can come before the shapes that
+  // we care about might touch.
+  const auto length = [](const geometry::ConstFinalConvexShapePtr& shape)
+    {
+      return shape ? shape->get_characteristic_length() : 0.0;
+    };
+
+  const double distance = test_footprints ?
+    length(profile_a.footprint) + length(profile_b.footprint) :
+    std::max(
+    length(profile_a.footprint) + length(profile_b.vicinity),
+    length(profile_a.vicinity) + length(profile_b.footprint));
+
   if (output_conflicts)
     output_conflicts->clear();
 
-  while (a_it != trajectory_a.end() && b_it != trajectory_b.end())
+  if (!overlap(tree_a.nodes.front().box,
+    adjust_bounding_box(tree_b.nodes.front().box, distance)))
+  {
+    // The trajectories never come near each other
+    if (statistics)
+      ++statistics->trajectory_pairs_pruned;
+
+    return rmf_utils::nullopt;
+  }
+
+  std::vector<SegmentPair> segment_pairs;
+  collect_segment_pairs(
+    tree_a, 0, tree_b, 0, distance, segment_pairs, statistics);
+
+  // Visit the segment pairs in chronological order so that the earliest
+  // conflict is found first.
+  std::sort(segment_pairs.begin(), segment_pairs.end());
+
+  const auto& footprint_radius_a = prepared_a.footprint_radius;
+  const auto& vicinity_radius_a = prepared_a.vicinity_radius;
+  const auto& footprint_radius_b = prepared_b.footprint_radius;
+  const auto& vicinity_radius_b = prepared_b.vicinity_radius;
+
+  std::shared_ptr<fcl::SplineMotion> motion_a;
+  std::shared_ptr<fcl::SplineMotion> motion_b;
+  const fcl::ContinuousCollisionRequest request = make_fcl_request();
+
+  for (const auto& segment_pair : segment_pairs)
   {
-    if (!spline_a)
-      spline_a = Spline(a_it);
+    const std::size_t i_a = segment_pair.first;
+    const std::size_t i_b = segment_pair.second;
 
-    if (!spline_b)
-      spline_b = Spline(b_it);
+    const Spline& spline_a = tree_a.splines[i_a];
+    const Spline& spline_b = tree_b.splines[i_b];
 
     const Time start_time =
-      std::max(spline_a->start_time(), spline_b->start_time());
+      std::max(spline_a.start_time(), spline_b.start_time());
 
     const Time finish_time =
-      std::min(spline_a->finish_time(), spline_b->finish_time());
+      std::min(spline_a.finish_time(), spline_b.finish_time());
+
+    // Segments that only touch at an instant are not considered, unless they
+    // are where the overlap of the trajectories begins.
+    if (finish_time <= start_time
+      && !(i_a == initial_a && i_b == initial_b))
+      continue;
+
+    // We only set up the FCL motions once we know that they will be needed
+    bool motions_ready = false;
+    const auto check = [&](
+      const geometry::FinalConvexShape& shape_a,
+      const rmf_utils::optional<double>& radius_a,
+      const geometry::FinalConvexShape& shape_b,
+      const rmf_utils::optional<double>& radius_b)
+      -> rmf_utils::optional<fcl::FCL_REAL>
+      {
+        if (radius_a && radius_b)
+        {
+          if (statistics)
+            ++statistics->analytic_checks;
 
-    *motion_a = spline_a->to_fcl(start_time, finish_time);
-    *motion_b = spline_b->to_fcl(start_time, finish_time);
+          return check_circle_collision(
+            spline_a, *radius_a, spline_b, *radius_b, start_time, finish_time);
+        }
+
+        if (!motions_ready)
+        {
+          if (!motion_a)
+          {
+            motion_a = make_uninitialized_fcl_spline_motion();
+            motion_b = make_uninitialized_fcl_spline_motion();
+          }
+
+          *motion_a = spline_a.to_fcl(start_time, finish_time);
+          *motion_b = spline_b.to_fcl(start_time, finish_time);
+          motions_ready = true;
+        }
+
+        if (statistics)
+          ++statistics->narrowphase_checks;
+
+        return check_collision(shape_a, motion_a, shape_b, motion_b, request);
+      };
+
+    // The iterators of a conflict mark the end of each segment
+    const auto conflict = [&](const Time time)
+      {
+        return Conflict{
+          internal::get_iterator(trajectory_a, i_a + 1),
+          internal::get_iterator(trajectory_b, i_b + 1),
+          time
+        };
+      };
+
+    const auto prune = [&]()
+      {
+        if (statistics)
+          ++statistics->segment_pairs_pruned;
+      };
 
     if (test_footprints)
     {
-      const auto bound_a = get_bounding_footprint(*spline_a, profile_a);
-      const auto bound_b = get_bounding_footprint(*spline_b, profile_b);
+      const auto bound_a = get_bounding_footprint(spline_a, profile_a);
+      const auto bound_b = get_bounding_footprint(spline_b, profile_b);
 
       if (overlap(bound_a, bound_b))
       {
-        if (const auto collision = check_collision(
-            *profile_a.footprint, motion_a,
-            *profile_b.footprint, motion_b, request))
+        if (const auto collision =
+          check(
+            *profile_a.footprint, footprint_radius_a,
+            *profile_b.footprint, footprint_radius_b))
         {
           const auto time = compute_time(*collision, start_time, finish_time);
           if (!output_conflicts)
             return time;
 
-          output_conflicts->emplace_back(Conflict{a_it, b_it, time});
+          output_conflicts->emplace_back(conflict(time));
         }
       }
+      else
+      {
+        prune();
+      }
     }
     else
     {
-      const auto bound_a = get_bounding_profile(*spline_a, profile_a);
-      const auto bound_b = get_bounding_profile(*spline_b, profile_b);
+      const auto bound_a = get_bounding_profile(spline_a, profile_a);
+      const auto bound_b = get_bounding_profile(spline_b, profile_b);
 
       if (overlap(bound_a.footprint, bound_b.vicinity))
       {
-        if (const auto collision = check_collision(
-            *profile_a.footprint, motion_a,
-            *profile_b.vicinity, motion_b, request))
+        if (const auto collision =
+          check(
+            *profile_a.footprint, footprint_radius_a,
+            *profile_b.vicinity, vicinity_radius_b))
         {
           const auto time = compute_time(*collision, start_time, finish_time);
           if (!output_conflicts)
             return time;
 
-          output_conflicts->emplace_back(Conflict{a_it, b_it, time});
+          output_conflicts->emplace_back(conflict(time));
         }
       }
+      else
+      {
+        prune();
+      }
 
-      if (test_complement && overlap(bound_a.vicinity, bound_b.footprint))
+      if (test_complement)
       {
-        if (const auto collision = check_collision(
-            *profile_a.vicinity, motion_a,
-            *profile_b.footprint, motion_b, request))
+        if (overlap(bound_a.vicinity, bound_b.footprint))
         {
-          const auto time = compute_time(*collision, start_time, finish_time);
-          if (!output_conflicts)
-            return time;
-
-          output_conflicts->emplace_back(Conflict{a_it, b_it, time});
+          if (const auto collision =
+            check(
+              *profile_a.vicinity, vicinity_radius_a,
+              *profile_b.footprint, footprint_radius_b))
+          {
+            const auto time =
+              compute_time(*collision, start_time, finish_time);
+            if (!output_conflicts)
+              return time;
+
+            output_conflicts->emplace_back(conflict(time));
+          }
+        }
+        else
+        {
+          prune();
         }
       }
     }
-
-    if (spline_a->finish_time() < spline_b->finish_time())
-    {
-      spline_a = rmf_utils::nullopt;
-      ++a_it;
-    }
-    else if (spline_b->finish_time() < spline_a->finish_time())
-    {
-      spline_b = rmf_utils::nullopt;
-      ++b_it;
-    }
-    else
-    {
-      spline_a = rmf_utils::nullopt;
-      ++a_it;
-
-      spline_b = rmf_utils::nullopt;
-      ++b_it;
-    }
   }
 
   if (!output_conflicts)
@@ -643,6 +996,71 @@ rmf_utils::optional<rmf_traffic::Time> DetectConflict::Implementation::between(
   return output_conflicts->front().time;
 }
 
+} // anonymous namespace
+
+//==============================================================================
+rmf_utils::optional<rmf_traffic::Time> DetectConflict::Implementation::between(
+  const Profile& input_profile_a,
+  const Trajectory& trajectory_a,
+  const Profile& input_profile_b,
+  const Trajectory& trajectory_b,
+  Interpolate /*interpolation*/,
+  std::vector<Conflict>* output_conflicts,
+  Statistics* statistics)
+{
+  check_segment_count(trajectory_a, trajectory_b);
+
+  Profile::Implementation profile_a = convert_profile(input_profile_a);
+  Profile::Implementation profile_b = convert_profile(input_profile_b);
+
+  if (!may_conflict(profile_a, trajectory_a, profile_b, trajectory_b))
+    return rmf_utils::nullopt;
+
+  return between_prepared(
+    PreparedTrajectory(std::move(profile_a), trajectory_a),
+    PreparedTrajectory(std::move(profile_b), trajectory_b),
+    output_conflicts, statistics);
+}
+
+//==============================================================================
+auto DetectConflict::between_many(
+  const Profile& input_profile,
+  const Trajectory& trajectory,
+  const std::vector<Other>& others,
+  Interpolate /*interpolation*/) -> rmf_utils::optional<Conflict>
+{
+  const Profile::Implementation profile = convert_profile(input_profile);
+
+  // We wait until we know that at least one of the others might conflict
+  // before preparing this trajectory.
+  std::unique_ptr<PreparedTrajectory> prepared;
+
+  for (std::size_t i = 0; i < others.size(); ++i)
+  {
+    const Trajectory& other_trajectory = *others[i].trajectory;
+    check_segment_count(trajectory, other_trajectory);
+
+    Profile::Implementation other_profile =
+      convert_profile(*others[i].profile);
+
+    if (!may_conflict(profile, trajectory, other_profile, other_trajectory))
+      continue;
+
+    if (!prepared)
+      prepared = std::make_unique<PreparedTrajectory>(profile, trajectory);
+
+    const auto time = between_prepared(
+      *prepared,
+      PreparedTrajectory(std::move(other_profile), other_trajectory),
+      nullptr, nullptr);
+
+    if (time)
+      return Conflict{i, *time};
+  }
+
+  return rmf_utils::nullopt;
+}
+
 namespace internal {
 //==============================================================================
 bool detect_conflicts(
@@ -697,6 +1115,10 @@ bool detect_conflicts(
     finish_time < trajectory_finish_time ?
     ++trajectory.find(finish_time) : trajectory.end();
 
+  const auto cache = get_segment_cache(trajectory);
+  // The spline that ends at the waypoint of begin_it
+  std::size_t segment = get_raw_iterator(begin_it).index - 1;
+
   std::shared_ptr<fcl::SplineMotion> motion_trajectory =
     make_uninitialized_fcl_spline_motion();
   std::shared_ptr<internal::StaticMotion> motion_region =
@@ -710,9 +1132,9 @@ bool detect_conflicts(
   if (output_conflicts)
     output_conflicts->clear();
 
-  for (auto it = begin_it; it != end_it; ++it)
+  for (auto it = begin_it; it != end_it; ++it, ++segment)
   {
-    Spline spline_trajectory{it};
+    const Spline& spline_trajectory = cache->splines[segment];
 
     const Time spline_start_time =
       std::max(spline_trajectory.start_time(), start_time);
@@ -760,6 +1182,129 @@ bool detect_conflicts(
 
   return !output_conflicts->empty();
 }
+
+//==============================================================================
+std::shared_ptr<const SegmentCache> get_segment_cache(
+  const Trajectory& trajectory)
+{
+  const WaypointArrays& arrays = *get_raw_iterator(trajectory.begin()).arrays;
+
+  std::shared_ptr<const SegmentCache> cache =
+    std::atomic_load(&arrays.segment_cache);
+  if (cache)
+    return cache;
+
+  // If several threads get here at once, they will each compute the same
+  // cache, and it does not matter whose gets stored.
+  const auto new_cache = std::make_shared<SegmentCache>();
+  const std::size_t num_segments = arrays.size() > 0 ? arrays.size() - 1 : 0;
+  new_cache->splines.reserve(num_segments);
+  new_cache->boxes.reserve(num_segments);
+  for (std::size_t i = 1; i < arrays.size(); ++i)
+  {
+    new_cache->splines.emplace_back(RawIterator{&arrays, i});
+    new_cache->boxes.push_back(
+      rmf_traffic::get_bounding_box(new_cache->splines.back()));
+  }
+
+  if (num_segments > 0)
+  {
+    new_cache->nodes.reserve(2*num_segments - 1);
+    build_segment_tree(*new_cache, 0, num_segments);
+  }
+
+  cache = new_cache;
+  std::atomic_store(&arrays.segment_cache, cache);
+  return cache;
+}
+
+//==============================================================================
+std::size_t SegmentCache::find(const Time time) const
+{
+  return static_cast<std::size_t>(std::lower_bound(
+      splines.begin(), splines.end(), time,
+      [](const Spline& spline, const Time t)
+      {
+        return spline.finish_time() < t;
+      }) - splines.begin());
+}
+
+//==============================================================================
+BoundingBox void_box()
+{
+  constexpr double inf = std::numeric_limits<double>::infinity();
+  return BoundingBox{
+    Eigen::Vector2d{inf, inf},
+    Eigen::Vector2d{-inf, -inf}
+  };
+}
+
+//==============================================================================
+BoundingBox adjust_bounding_box(
+  const BoundingBox& input,
+  const double value)
+{
+  BoundingBox box = input;
+  box.min -= Eigen::Vector2d{value, value};
+  box.max += Eigen::Vector2d{value, value};
+
+  return box;
+}
+
+//==============================================================================
+bool overlap(
+  const BoundingBox& box_a,
+  const BoundingBox& box_b)
+{
+  for (int i = 0; i < 2; ++i)
+  {
+    if (box_a.max[i] < box_b.min[i])
+      return false;
+
+    if (box_b.max[i] < box_a.min[i])
+      return false;
+  }
+
+  return true;
+}
+
+//==============================================================================
+BoundingBox get_bounding_box(const Trajectory& trajectory)
+{
+  assert(trajectory.size() > 0);
+  const auto cache = get_segment_cache(trajectory);
+  if (!cache->nodes.empty())
+    return cache->nodes.front().box;
+
+  const Eigen::Vector2d p0 = trajectory.front().position().block<2, 1>(0, 0);
+  return BoundingBox{p0, p0};
+}
+
+//==============================================================================
+BoundingBox get_bounding_box(
+  const Trajectory& trajectory,
+  const Profile& profile)
+{
+  double length = 0.0;
+  if (const auto& footprint = profile.footprint())
+    length = std::max(length, footprint->get_characteristic_length());
+
+  if (const auto& vicinity = profile.vicinity())
+    length = std::max(length, vicinity->get_characteristic_length());
+
+  return adjust_bounding_box(get_bounding_box(trajectory), length);
+}
+
+//==============================================================================
+BoundingBox get_bounding_box(const geometry::Space& space)
+{
+  const Eigen::Vector2d p = space.get_pose().translation();
+  const double length = space.get_shape() ?
+    space.get_shape()->get_characteristic_length() : 0.0;
+
+  return adjust_bounding_box(BoundingBox{p, p}, length);
+}
+
 } // namespace internal
 
 } // namespace rmf_traffic
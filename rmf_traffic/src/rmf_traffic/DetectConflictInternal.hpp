@@ -21,9 +21,11 @@
 #include <rmf_traffic/DetectConflict.hpp>
 
 #include "geometry/ShapeInternal.hpp"
+#include "Spline.hpp"
 
 #include <rmf_traffic/Profile.hpp>
 #include <rmf_traffic/Trajectory.hpp>
+#include <rmf_traffic/geometry/Space.hpp>
 
 #include <unordered_map>
 
@@ -42,13 +44,36 @@ public:
 
   using Conflicts = std::vector<Conflict>;
 
+  /// Counters that describe how much work was avoided by the bounding volume
+  /// checks in between()
+  struct Statistics
+  {
+    /// Trajectory pairs that were ruled out by the boxes of their whole routes
+    std::size_t trajectory_pairs_pruned = 0;
+
+    /// Pairs of segment runs that were ruled out by the segment trees
+    std::size_t segment_run_pairs_pruned = 0;
+
+    /// Pairs of individual segments that were ruled out by the boxes of the
+    /// specific footprints and vicinities that needed to be tested
+    std::size_t segment_pairs_pruned = 0;
+
+    /// Collision checks that had to be performed by FCL
+    std::size_t narrowphase_checks = 0;
+
+    /// Collision checks between circles that were solved analytically instead
+    /// of using FCL
+    std::size_t analytic_checks = 0;
+  };
+
   static rmf_utils::optional<Time> between(
     const Profile& profile_a,
     const Trajectory& trajectory_a,
     const Profile& profile_b,
     const Trajectory& trajectory_b,
     Interpolate interpolation,
-    std::vector<Conflict>* output_conflicts = nullptr);
+    std::vector<Conflict>* output_conflicts = nullptr,
+    Statistics* statistics = nullptr);
 
 };
 
@@ -71,6 +96,96 @@ bool detect_conflicts(
   const Spacetime& region,
   DetectConflict::Implementation::Conflicts* output_conflicts = nullptr);
 
+//==============================================================================
+struct BoundingBox
+{
+  Eigen::Vector2d min;
+  Eigen::Vector2d max;
+};
+
+//==============================================================================
+/// The spline of each segment of a trajectory, and the box that is swept out by
+/// the center of the trajectory along that segment. Entry i describes the
+/// motion from waypoint i to waypoint i+1.
+struct SegmentCache
+{
+  /// A node in a hierarchy of bounding boxes over the segments. The root node
+  /// covers the whole route, and each node below it covers a contiguous run of
+  /// segments. Like the segment boxes, these only cover the path of the
+  /// trajectory's center.
+  struct Node
+  {
+    // The range of segments [begin, end) covered by this node
+    std::size_t begin;
+    std::size_t end;
+
+    Time start_time;
+    Time finish_time;
+    BoundingBox box;
+
+    // The children of this node. These are only meaningful if the node covers
+    // more than one segment.
+    std::size_t left;
+    std::size_t right;
+
+    bool leaf() const
+    {
+      return end - begin == 1;
+    }
+  };
+
+  std::vector<Spline> splines;
+  std::vector<BoundingBox> boxes;
+
+  /// The nodes of the hierarchy, with the root first. This is empty if the
+  /// trajectory has no segments.
+  std::vector<Node> nodes;
+
+  /// Get the index of the segment that is active at the given time. This
+  /// matches the behavior of Trajectory::find().
+  std::size_t find(Time time) const;
+};
+
+//==============================================================================
+/// Get the segment data of a trajectory. This is only computed the first time
+/// that it is needed after the trajectory was created or last modified. The
+/// result stays valid even if the trajectory is modified afterwards, but it
+/// will no longer describe the trajectory.
+std::shared_ptr<const SegmentCache> get_segment_cache(
+  const Trajectory& trajectory);
+
+//==============================================================================
+/// Create a bounding box which will never overlap with any other BoundingBox
+BoundingBox void_box();
+
+//==============================================================================
+/// Grow (or shrink, for a negative value) the box by the given value along
+/// every side.
+BoundingBox adjust_bounding_box(
+  const BoundingBox& input,
+  double value);
+
+//==============================================================================
+bool overlap(
+  const BoundingBox& box_a,
+  const BoundingBox& box_b);
+
+//==============================================================================
+/// Get the box that is swept out by the center of the trajectory over its full
+/// duration. The trajectory must contain at least one waypoint.
+BoundingBox get_bounding_box(const Trajectory& trajectory);
+
+//==============================================================================
+/// Get the box that is swept out by the full profile (footprint and vicinity)
+/// of a participant following the trajectory.
+BoundingBox get_bounding_box(
+  const Trajectory& trajectory,
+  const Profile& profile);
+
+//==============================================================================
+/// Get a box that contains the whole space.
+BoundingBox get_bounding_box(const geometry::Space& space);
+
 } // namespace internal
 
 } // namespace rmf_traffic
@@ -33,20 +33,25 @@ std::unique_ptr<Motion> Motion::compute_cubic_splines(
     // *INDENT-ON*
   }
 
-  using const_iterator = internal::WaypointList::const_iterator;
-  const const_iterator begin = internal::get_raw_iterator(input_begin);
-  const const_iterator end = internal::get_raw_iterator(input_end);
+  const internal::RawIterator begin = internal::get_raw_iterator(input_begin);
+  const internal::RawIterator end = internal::get_raw_iterator(input_end);
+  const internal::WaypointArrays& arrays = *begin.arrays;
 
-  if (++const_iterator(begin) == end)
+  if (begin.index + 1 == end.index)
   {
-    const auto& point = *begin;
     return std::make_unique<SinglePointMotion>(
-      point.data.time, point.data.position, point.data.velocity);
+      arrays.times[begin.index],
+      arrays.positions[begin.index],
+      arrays.velocities[begin.index]);
   }
 
   std::vector<Spline> splines;
-  for (auto it = ++const_iterator(begin); it != end; ++it)
+  splines.reserve(end.index - begin.index - 1);
+  for (auto it = internal::RawIterator{&arrays, begin.index + 1};
+    it.index != end.index; ++it.index)
+  {
     splines.emplace_back(Spline(it));
+  }
 
   if (splines.size() == 1)
     return std::make_unique<SplineMotion>(std::move(splines[0]));
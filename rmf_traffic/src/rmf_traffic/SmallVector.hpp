@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC__SMALLVECTOR_HPP
+#define SRC__RMF_TRAFFIC__SMALLVECTOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace rmf_traffic {
+namespace internal {
+
+//==============================================================================
+/// A vector that keeps up to N elements inside of itself, and only moves them
+/// to the heap once it grows past that. Elements are addressed by index, and
+/// only the operations that the Trajectory storage needs are provided.
+template<typename T, std::size_t N>
+class SmallVector
+{
+public:
+
+  using value_type = T;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  SmallVector()
+  : _data(inline_data()),
+    _size(0),
+    _capacity(N)
+  {
+    // Do nothing
+  }
+
+  SmallVector(const SmallVector& other)
+  : SmallVector()
+  {
+    *this = other;
+  }
+
+  SmallVector(SmallVector&& other)
+  : SmallVector()
+  {
+    *this = std::move(other);
+  }
+
+  SmallVector& operator=(const SmallVector& other)
+  {
+    if (this == &other)
+      return *this;
+
+    clear();
+    reserve(other._size);
+    for (std::size_t i = 0; i < other._size; ++i)
+      new (_data + i) T(other._data[i]);
+
+    _size = other._size;
+    return *this;
+  }
+
+  SmallVector& operator=(SmallVector&& other)
+  {
+    if (this == &other)
+      return *this;
+
+    clear();
+    if (!other.is_inline())
+    {
+      // Take over the heap buffer of the other vector
+      release();
+      _data = other._data;
+      _capacity = other._capacity;
+      _size = other._size;
+
+      other._data = other.inline_data();
+      other._capacity = N;
+      other._size = 0;
+      return *this;
+    }
+
+    reserve(other._size);
+    for (std::size_t i = 0; i < other._size; ++i)
+      new (_data + i) T(std::move(other._data[i]));
+
+    _size = other._size;
+    other.clear();
+    return *this;
+  }
+
+  ~SmallVector()
+  {
+    clear();
+    release();
+  }
+
+  std::size_t size() const
+  {
+    return _size;
+  }
+
+  bool empty() const
+  {
+    return _size == 0;
+  }
+
+  T& operator[](const std::size_t index)
+  {
+    assert(index < _size);
+    return _data[index];
+  }
+
+  const T& operator[](const std::size_t index) const
+  {
+    assert(index < _size);
+    return _data[index];
+  }
+
+  T& front()
+  {
+    return (*this)[0];
+  }
+
+  const T& front() const
+  {
+    return (*this)[0];
+  }
+
+  T& back()
+  {
+    return (*this)[_size-1];
+  }
+
+  const T& back() const
+  {
+    return (*this)[_size-1];
+  }
+
+  iterator begin()
+  {
+    return _data;
+  }
+
+  const_iterator begin() const
+  {
+    return _data;
+  }
+
+  iterator end()
+  {
+    return _data + _size;
+  }
+
+  const_iterator end() const
+  {
+    return _data + _size;
+  }
+
+  void reserve(const std::size_t new_capacity)
+  {
+    if (new_capacity <= _capacity)
+      return;
+
+    T* const new_data =
+      static_cast<T*>(::operator new(new_capacity * sizeof(T)));
+
+    for (std::size_t i = 0; i < _size; ++i)
+    {
+      new (new_data + i) T(std::move(_data[i]));
+      _data[i].~T();
+    }
+
+    release();
+    _data = new_data;
+    _capacity = new_capacity;
+  }
+
+  void push_back(T value)
+  {
+    grow_for(_size + 1);
+    new (_data + _size) T(std::move(value));
+    ++_size;
+  }
+
+  /// Insert the value so that it ends up at the given index
+  void insert(const std::size_t index, T value)
+  {
+    assert(index <= _size);
+    if (index == _size)
+      return push_back(std::move(value));
+
+    grow_for(_size + 1);
+    new (_data + _size) T(std::move(_data[_size-1]));
+    std::move_backward(_data + index, _data + _size - 1, _data + _size);
+    _data[index] = std::move(value);
+    ++_size;
+  }
+
+  /// Erase the elements in the index range [first, last)
+  void erase(const std::size_t first, const std::size_t last)
+  {
+    assert(first <= last && last <= _size);
+    if (first == last)
+      return;
+
+    std::move(_data + last, _data + _size, _data + first);
+    const std::size_t new_size = _size - (last - first);
+    for (std::size_t i = new_size; i < _size; ++i)
+      _data[i].~T();
+
+    _size = new_size;
+  }
+
+  void pop_back()
+  {
+    assert(_size > 0);
+    --_size;
+    _data[_size].~T();
+  }
+
+  void clear()
+  {
+    for (std::size_t i = 0; i < _size; ++i)
+      _data[i].~T();
+
+    _size = 0;
+  }
+
+private:
+
+  T* inline_data()
+  {
+    return reinterpret_cast<T*>(&_storage);
+  }
+
+  bool is_inline() const
+  {
+    return _data == reinterpret_cast<const T*>(&_storage);
+  }
+
+  void grow_for(const std::size_t required)
+  {
+    if (required > _capacity)
+      reserve(std::max(required, 2*_capacity));
+  }
+
+  void release()
+  {
+    if (!is_inline())
+      ::operator delete(_data);
+
+    _data = inline_data();
+    _capacity = N;
+  }
+
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type _storage[N];
+  T* _data;
+  std::size_t _size;
+  std::size_t _capacity;
+};
+
+} // namespace internal
+} // namespace rmf_traffic
+
+#endif // SRC__RMF_TRAFFIC__SMALLVECTOR_HPP
@@ -63,51 +63,22 @@ std::array<Eigen::Vector4d, 3> compute_coefficients(
 }
 
 //==============================================================================
-Spline::Parameters compute_parameters(
-  const Trajectory::const_iterator& finish_it)
+Spline::Parameters compute_parameters(const internal::RawIterator& finish_it)
 {
-  const Trajectory::const_iterator start_it =
-    --Trajectory::const_iterator(finish_it);
+  const internal::WaypointArrays& arrays = *finish_it.arrays;
+  const std::size_t finish = finish_it.index;
+  assert(0 < finish && finish < arrays.size());
+  const std::size_t start = finish - 1;
 
-  const Trajectory::Waypoint& start = *start_it;
-  const Trajectory::Waypoint& finish = *finish_it;
-
-  const Time start_time = start.time();
-  const Time finish_time = finish.time();
+  const Time start_time = arrays.times[start];
+  const Time finish_time = arrays.times[finish];
 
   const double delta_t = compute_delta_t(finish_time, start_time);
 
-  const Eigen::Vector3d x0 = start.position();
-  const Eigen::Vector3d x1 = finish.position();
-  const Eigen::Vector3d v0 = delta_t * start.velocity();
-  const Eigen::Vector3d v1 = delta_t * finish.velocity();
-
-  return {
-    compute_coefficients(x0, x1, v0, v1),
-    delta_t,
-    {start_time, finish_time}
-  };
-}
-
-//==============================================================================
-Spline::Parameters compute_parameters(
-  const internal::WaypointList::const_iterator& finish_it)
-{
-  const internal::WaypointList::const_iterator start_it =
-    --internal::WaypointList::const_iterator(finish_it);
-
-  const internal::WaypointElement::Data& start = start_it->data;
-  const internal::WaypointElement::Data& finish = finish_it->data;
-
-  const Time start_time = start.time;
-  const Time finish_time = finish.time;
-
-  const double delta_t = compute_delta_t(finish_time, start_time);
-
-  const Eigen::Vector3d x0 = start.position;
-  const Eigen::Vector3d x1 = finish.position;
-  const Eigen::Vector3d v0 = delta_t * start.velocity;
-  const Eigen::Vector3d v1 = delta_t * finish.velocity;
+  const Eigen::Vector3d& x0 = arrays.positions[start];
+  const Eigen::Vector3d& x1 = arrays.positions[finish];
+  const Eigen::Vector3d v0 = delta_t * arrays.velocities[start];
+  const Eigen::Vector3d v1 = delta_t * arrays.velocities[finish];
 
   return {
     compute_coefficients(x0, x1, v0, v1),
@@ -187,13 +158,13 @@ const Eigen::Matrix4d M_inv = make_M_inv();
 
 //==============================================================================
 Spline::Spline(const Trajectory::const_iterator& it)
-: params(compute_parameters(it))
+: params(compute_parameters(internal::get_raw_iterator(it)))
 {
   // Do nothing
 }
 
 //==============================================================================
-Spline::Spline(const internal::WaypointList::const_iterator& it)
+Spline::Spline(const internal::RawIterator& it)
 : params(compute_parameters(it))
 {
   // Do nothing
@@ -43,7 +43,7 @@ public:
 
   /// Create a spline that goes from the end of the preceding to the Waypoint of
   /// `it`.
-  Spline(const internal::WaypointList::const_iterator& it);
+  Spline(const internal::RawIterator& it);
 
   /// Compute the knots for the motion of this spline from start_time to
   /// finish_time, scaled to a "time" range of [0, 1].
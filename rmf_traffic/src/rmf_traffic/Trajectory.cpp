@@ -21,67 +21,113 @@
 #include "MotionInternal.hpp"
 #include "TrajectoryInternal.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <string>
+#include <type_traits>
 
 namespace rmf_traffic {
 
 namespace internal {
+namespace {
+//==============================================================================
+// The key held by an end() iterator
+constexpr std::size_t EndKey = std::numeric_limits<std::size_t>::max();
+
+//==============================================================================
+template<typename Container>
+void rotate_range(
+  Container& container,
+  const std::size_t first,
+  const std::size_t middle,
+  const std::size_t last)
+{
+  std::rotate(
+    container.begin() + first,
+    container.begin() + middle,
+    container.begin() + last);
+}
+} // anonymous namespace
+
+//==============================================================================
+std::size_t WaypointArrays::lower_bound(const Time time) const
+{
+  return static_cast<std::size_t>(
+    std::lower_bound(times.begin(), times.end(), time) - times.begin());
+}
+
 //==============================================================================
 class TrajectoryIteratorImplementation
 {
 public:
 
-  WaypointList::iterator raw_iterator;
-  const Trajectory::Implementation* parent;
+  // The key of the waypoint that this iterator refers to. Keys stay attached
+  // to their waypoint while other waypoints are inserted, erased, or moved, so
+  // iterators remain valid through those changes.
+  std::size_t key = EndKey;
+  const Trajectory::Implementation* parent = nullptr;
 
   template<typename SegT>
-  Trajectory::base_iterator<SegT> make_iterator(
-    internal::WaypointList::iterator it) const
+  Trajectory::base_iterator<SegT> make_iterator(std::size_t other_key) const
   {
     Trajectory::base_iterator<SegT> result;
-    result._pimpl->raw_iterator = it;
+    result._pimpl->key = other_key;
     result._pimpl->parent = parent;
 
     return result;
   }
 
-  template<typename SegT>
-  Trajectory::base_iterator<SegT> post_increment()
+  bool is_end() const
   {
-    const Trajectory::base_iterator<SegT> old_it =
-      make_iterator<SegT>(raw_iterator);
+    return key == EndKey;
+  }
+
+  std::size_t index() const;
+
+  Time time() const;
 
-    ++raw_iterator;
+  void increment();
 
+  void decrement();
+
+  template<typename SegT>
+  Trajectory::base_iterator<SegT> post_increment()
+  {
+    const Trajectory::base_iterator<SegT> old_it = make_iterator<SegT>(key);
+    increment();
     return old_it;
   }
 
   template<typename SegT>
   Trajectory::base_iterator<SegT> post_decrement()
   {
-    const Trajectory::base_iterator<SegT> old_it =
-      make_iterator<SegT>(raw_iterator);
-
-    --raw_iterator;
-
+    const Trajectory::base_iterator<SegT> old_it = make_iterator<SegT>(key);
+    decrement();
     return old_it;
   }
 
-  static WaypointList::const_iterator raw(
-    const Trajectory::const_iterator& iterator)
-  {
-    return iterator._pimpl->raw_iterator;
-  }
+  static RawIterator raw(const Trajectory::const_iterator& iterator);
+
+  static Trajectory::const_iterator at(
+    const Trajectory& trajectory,
+    std::size_t index);
 };
 
 //==============================================================================
-WaypointList::const_iterator get_raw_iterator(
-  const Trajectory::const_iterator& iterator)
+RawIterator get_raw_iterator(const Trajectory::const_iterator& iterator)
 {
   return TrajectoryIteratorImplementation::raw(iterator);
 }
 
+//==============================================================================
+Trajectory::const_iterator get_iterator(
+  const Trajectory& trajectory,
+  const std::size_t index)
+{
+  return TrajectoryIteratorImplementation::at(trajectory, index);
+}
+
 } // namespace internal
 
 //==============================================================================
@@ -89,55 +135,139 @@ class Trajectory::Waypoint::Implementation
 {
 public:
 
-  // Note: these fields will be filled in by the
-  // Trajectory::Implementation::insert() function.
-  internal::WaypointList::iterator myself;
   Trajectory::Implementation* parent;
+  std::size_t key;
 
-  internal::WaypointElement::Data& data()
-  {
-    return myself->data;
-  }
+  std::size_t index() const;
 
-  const internal::WaypointElement::Data& data() const
-  {
-    return myself->data;
-  }
+};
 
-  Time time() const
-  {
-    return data().time;
-  }
+namespace {
+//==============================================================================
+// The Waypoint handles of a Trajectory refer to implementations that are owned
+// by the Trajectory, so they must never delete or copy them.
+void do_not_delete(Trajectory::Waypoint::Implementation*)
+{
+  // Do nothing
+}
 
-};
+//==============================================================================
+Trajectory::Waypoint::Implementation* do_not_copy(
+  const Trajectory::Waypoint::Implementation*)
+{
+  // Waypoints cannot be copied, so this will never be called
+  return nullptr;
+}
+} // anonymous namespace
 
 //==============================================================================
 class Trajectory::Implementation
 {
 public:
 
-  internal::OrderMap ordering;
-  internal::WaypointList segments;
+  internal::WaypointArrays arrays;
+
+  // The key of each waypoint, in the same order as the arrays
+  internal::WaypointVector<std::size_t> keys;
+
+  // The current index of each key within the arrays, or EndKey if the key is
+  // not in use
+  internal::WaypointVector<std::size_t> indices;
+
+  // Keys that are not in use and may be recycled
+  std::vector<std::size_t> free_keys;
+
+  // A Waypoint together with the implementation that it refers to, so that
+  // making a handle does not need any allocations of its own.
+  struct Handle
+  {
+    Waypoint::Implementation impl;
+    Waypoint waypoint;
+
+    Handle(Implementation* parent, const std::size_t key)
+    : impl{parent, key},
+      waypoint(&impl)
+    {
+      // Do nothing
+    }
+
+    Handle(const Handle&) = delete;
+    Handle& operator=(const Handle&) = delete;
+  };
+
+  // We store a Handle for every key so that we can always safely return a
+  // reference to a Trajectory::Waypoint object. As long as the waypoint is in
+  // the Trajectory, any Trajectory::Waypoint reference that refers to it will
+  // remain valid. The handles of erased waypoints are kept around to be reused
+  // when their key is recycled. The first few handles are stored inline and
+  // the rest are allocated one at a time, so their addresses never change.
+  using HandleStorage =
+    typename std::aligned_storage<sizeof(Handle), alignof(Handle)>::type;
+  HandleStorage inline_handles[internal::InlineWaypoints];
+  std::vector<std::unique_ptr<Handle>> extra_handles;
 
   template<typename SegT>
-  base_iterator<SegT> make_iterator(
-    internal::WaypointList::iterator iterator) const
+  base_iterator<SegT> make_iterator(std::size_t key) const
   {
     base_iterator<SegT> it;
-    it._pimpl->raw_iterator = std::move(iterator);
+    it._pimpl->key = key;
     it._pimpl->parent = this;
 
     return it;
   }
 
-  std::unique_ptr<Waypoint> make_segment(
-    internal::WaypointList::iterator iterator)
+  iterator iterator_at(const std::size_t index) const
+  {
+    return make_iterator<Waypoint>(
+      index < keys.size() ? keys[index] : internal::EndKey);
+  }
+
+  template<typename SegT>
+  std::size_t index_of(const base_iterator<SegT>& it) const
   {
-    std::unique_ptr<Waypoint> seg(new Waypoint);
-    seg->_pimpl->myself = std::move(iterator);
-    seg->_pimpl->parent = this;
+    return it._pimpl->is_end() ? keys.size() : indices[it._pimpl->key];
+  }
 
-    return seg;
+  void add_handle(const std::size_t key)
+  {
+    if (key < internal::InlineWaypoints)
+      new (&inline_handles[key]) Handle(this, key);
+    else
+      extra_handles.emplace_back(std::make_unique<Handle>(this, key));
+  }
+
+  Waypoint& waypoint(const std::size_t key) const
+  {
+    if (key < internal::InlineWaypoints)
+    {
+      const void* const storage = &inline_handles[key];
+      return const_cast<Handle*>(
+        static_cast<const Handle*>(storage))->waypoint;
+    }
+
+    return extra_handles[key - internal::InlineWaypoints]->waypoint;
+  }
+
+  std::size_t acquire_key()
+  {
+    if (!free_keys.empty())
+    {
+      const std::size_t key = free_keys.back();
+      free_keys.pop_back();
+      return key;
+    }
+
+    const std::size_t key = indices.size();
+    indices.push_back(internal::EndKey);
+    add_handle(key);
+    return key;
+  }
+
+  // Refresh the index of every key whose position is in [first, last)
+  void reindex(const std::size_t first, const std::size_t last)
+  {
+    for (std::size_t i = first; i < last; ++i)
+      indices[keys[i]] = i;
   }
 
   Implementation()
@@ -152,204 +282,276 @@ public:
 
   Implementation& operator=(const Implementation& other)
   {
-    // Start by making a normal copy
-    ordering = other.ordering;
-    segments = other.segments;
+    if (this == &other)
+      return *this;
+
+    const std::size_t handle_count = indices.size();
 
-    // Now correct all the iterators to point to the freshly copied container
-    internal::WaypointList::iterator sit = segments.begin();
-    internal::OrderMap::iterator oit = ordering.begin();
-    for ( ; sit != segments.end(); ++sit, ++oit)
+    arrays = other.arrays;
+    keys = other.keys;
+    indices = other.indices;
+    free_keys = other.free_keys;
+
+    // The handles that we already have refer to this Implementation, so we
+    // only need to make handles for keys that we have not seen before. Any
+    // handles beyond the keys of the other Trajectory are kept as free keys.
+    for (std::size_t key = handle_count; key < indices.size(); ++key)
+      add_handle(key);
+
+    for (std::size_t key = indices.size(); key < handle_count; ++key)
     {
-      sit->myself = make_segment(sit);
-      oit->second = sit;
+      indices.push_back(internal::EndKey);
+      free_keys.push_back(key);
     }
 
     return *this;
   }
 
-  InsertionResult insert(internal::WaypointElement::Data data)
+  ~Implementation()
   {
-    const internal::OrderMap::iterator hint = ordering.lower_bound(data.time);
-    if (hint != ordering.end() && hint->first == data.time)
+    const std::size_t inline_count =
+      std::min(indices.size(), internal::InlineWaypoints);
+    for (std::size_t key = 0; key < inline_count; ++key)
+      reinterpret_cast<Handle*>(&inline_handles[key])->~Handle();
+  }
+
+  InsertionResult insert(
+    const Time time,
+    Eigen::Vector3d position,
+    Eigen::Vector3d velocity)
+  {
+    const std::size_t index = arrays.lower_bound(time);
+    if (index < arrays.size() && arrays.times[index] == time)
     {
       // We already have a Waypoint in the Trajectory that ends at this same
       // exact moment in time, so we will return the existing iterator along
       // with inserted==false.
-      assert(segments.size() > 0);
-      return InsertionResult{make_iterator<Waypoint>(hint->second), false};
+      return InsertionResult{iterator_at(index), false};
     }
 
-    const internal::WaypointList::const_iterator list_destination =
-      (hint == ordering.end()) ? segments.end() : hint->second;
-
-    const internal::WaypointList::iterator result =
-      segments.emplace(list_destination, std::move(data));
-    result->myself = make_segment(result);
-    assert(segments.size() > 0);
+    const std::size_t key = acquire_key();
+    arrays.times.insert(index, time);
+    arrays.positions.insert(index, std::move(position));
+    arrays.velocities.insert(index, std::move(velocity));
+    arrays.changed();
+    keys.insert(index, key);
+    reindex(index, keys.size());
 
-    ordering.emplace_hint(hint, data.time, result);
-    assert(ordering.size() > 0);
+    return InsertionResult{make_iterator<Waypoint>(key), true};
+  }
 
-    return InsertionResult{make_iterator<Waypoint>(result), true};
+  // Move the waypoint at index [from] so that it ends up at index [to],
+  // shifting the waypoints in between by one place.
+  void move(const std::size_t from, const std::size_t to)
+  {
+    if (from == to)
+      return;
+
+    const std::size_t first = std::min(from, to);
+    const std::size_t last = std::max(from, to) + 1;
+    const std::size_t middle = from < to ? from + 1 : from;
+
+    internal::rotate_range(arrays.times, first, middle, last);
+    internal::rotate_range(arrays.positions, first, middle, last);
+    internal::rotate_range(arrays.velocities, first, middle, last);
+    arrays.changed();
+    internal::rotate_range(keys, first, middle, last);
+    reindex(first, last);
   }
 
-  iterator find(Time time)
+  iterator find(Time time) const
   {
-    const auto it = ordering.lower_bound(time);
-    if (it == ordering.end())
-      return make_iterator<Waypoint>(segments.end());
+    const std::size_t index = arrays.lower_bound(time);
+    if (index == arrays.size())
+      return end();
 
     // If the time comes before the start of the Trajectory, then we return
     // the end() iterator
-    if (time < segments.begin()->data.time)
-      return make_iterator<Waypoint>(segments.end());
+    if (time < arrays.times.front())
+      return end();
+
+    return iterator_at(index);
+  }
 
-    return make_iterator<Waypoint>(it->second);
+  iterator lower_bound(Time time) const
+  {
+    return iterator_at(arrays.lower_bound(time));
   }
 
-  iterator lower_bound(Time time)
+  iterator erase(std::size_t first, std::size_t last)
   {
-    const auto it = ordering.lower_bound(time);
-    if (it == ordering.end())
-      return make_iterator<Waypoint>(segments.end());
+    for (std::size_t i = first; i < last; ++i)
+    {
+      indices[keys[i]] = internal::EndKey;
+      free_keys.push_back(keys[i]);
+    }
+
+    arrays.times.erase(first, last);
+    arrays.positions.erase(first, last);
+    arrays.velocities.erase(first, last);
+    arrays.changed();
+    keys.erase(first, last);
+    reindex(first, keys.size());
 
-    return make_iterator<Waypoint>(it->second);
+    return iterator_at(first);
   }
 
   iterator erase(iterator waypoint)
   {
-    ordering.erase(waypoint->_pimpl->myself->data.time);
-    return make_iterator<Waypoint>(segments.erase(waypoint->_pimpl->myself));
+    const std::size_t index = index_of(waypoint);
+    return erase(index, index + 1);
   }
 
   iterator erase(iterator first, iterator last)
   {
-    const auto seg_begin = first->_pimpl->myself;
-    const auto seg_end = last._pimpl->raw_iterator == segments.end() ?
-      segments.end() : last->_pimpl->myself;
-
-    const auto order_start = ordering.find(seg_begin->data.time);
-    const auto order_end = seg_end == segments.end() ?
-      ordering.end() : ordering.find(seg_end->data.time);
+    return erase(index_of(first), index_of(last));
+  }
 
-    ordering.erase(order_start, order_end);
-    return make_iterator<Waypoint>(segments.erase(seg_begin, seg_end));
+  iterator begin() const
+  {
+    return iterator_at(0);
   }
 
-  iterator begin()
+  iterator end() const
   {
-    return make_iterator<Waypoint>(segments.begin());
+    return make_iterator<Waypoint>(internal::EndKey);
   }
 
-  iterator end()
+  Waypoint& at(const std::size_t index) const
   {
-    return make_iterator<Waypoint>(segments.end());
+    return waypoint(keys[index]);
   }
 
 };
 
+//==============================================================================
+std::size_t Trajectory::Waypoint::Implementation::index() const
+{
+  return parent->indices[key];
+}
+
+namespace internal {
+//==============================================================================
+std::size_t TrajectoryIteratorImplementation::index() const
+{
+  return parent->indices[key];
+}
+
+//==============================================================================
+Time TrajectoryIteratorImplementation::time() const
+{
+  return parent->arrays.times[index()];
+}
+
+//==============================================================================
+void TrajectoryIteratorImplementation::increment()
+{
+  const std::size_t next = index() + 1;
+  key = next < parent->keys.size() ? parent->keys[next] : EndKey;
+}
+
+//==============================================================================
+void TrajectoryIteratorImplementation::decrement()
+{
+  const std::size_t current = is_end() ? parent->keys.size() : index();
+  assert(current > 0);
+  key = parent->keys[current - 1];
+}
+
+//==============================================================================
+RawIterator TrajectoryIteratorImplementation::raw(
+  const Trajectory::const_iterator& iterator)
+{
+  const TrajectoryIteratorImplementation& it = *iterator._pimpl;
+  return RawIterator{
+    &it.parent->arrays,
+    it.is_end() ? it.parent->arrays.size() : it.index()
+  };
+}
+
+//==============================================================================
+Trajectory::const_iterator TrajectoryIteratorImplementation::at(
+  const Trajectory& trajectory,
+  const std::size_t index)
+{
+  return trajectory._pimpl->iterator_at(index);
+}
+} // namespace internal
+
 //==============================================================================
 Eigen::Vector3d Trajectory::Waypoint::position() const
 {
-  return _pimpl->data().position;
+  return _pimpl->parent->arrays.positions[_pimpl->index()];
 }
 
 //==============================================================================
 Trajectory::Waypoint& Trajectory::Waypoint::position(
   Eigen::Vector3d new_position)
 {
-  _pimpl->data().position = std::move(new_position);
+  internal::WaypointArrays& arrays = _pimpl->parent->arrays;
+  arrays.positions[_pimpl->index()] = std::move(new_position);
+  arrays.changed();
   return *this;
 }
 
 //==============================================================================
 Eigen::Vector3d Trajectory::Waypoint::velocity() const
 {
-  return _pimpl->data().velocity;
+  return _pimpl->parent->arrays.velocities[_pimpl->index()];
 }
 
 //==============================================================================
 Trajectory::Waypoint& Trajectory::Waypoint::velocity(
   Eigen::Vector3d new_velocity)
 {
-  _pimpl->data().velocity = std::move(new_velocity);
+  internal::WaypointArrays& arrays = _pimpl->parent->arrays;
+  arrays.velocities[_pimpl->index()] = std::move(new_velocity);
+  arrays.changed();
   return *this;
 }
 
 //==============================================================================
 Time Trajectory::Waypoint::time() const
 {
-  return _pimpl->time();
+  return _pimpl->parent->arrays.times[_pimpl->index()];
 }
 
 //==============================================================================
 Trajectory::Waypoint& Trajectory::Waypoint::change_time(const Time new_time)
 {
-  internal::WaypointList::iterator data_it = _pimpl->myself;
-  internal::WaypointElement::Data& current_data = data_it->data;
-  const Time current_time = current_data.time;
+  Trajectory::Implementation& parent = *_pimpl->parent;
+  internal::WaypointArrays& arrays = parent.arrays;
+  const std::size_t current = _pimpl->index();
+  const Time current_time = arrays.times[current];
 
   if (current_time == new_time)
   {
-    // Short-circuit, since nothing is changing. The erase and re-insertion
-    // would be a waste of time in this case.
+    // Short-circuit, since nothing is changing.
     return *this;
   }
 
-  internal::OrderMap& ordering = _pimpl->parent->ordering;
-  internal::WaypointList& segments = _pimpl->parent->segments;
-  const internal::OrderMap::const_iterator current_order_it =
-    ordering.find(current_time);
-  assert(current_order_it != ordering.end());
-
-  const internal::OrderMap::const_iterator hint =
-    ordering.lower_bound(new_time);
-
-  if (current_order_it == hint)
-  {
-    // The Waypoint is already in the correct location within the list, so it
-    // does not need to be moved. We can just update its entry in the OrderMap.
-
-    // We need to create a new_hint iterator which points to the iterator after
-    // hint because the hint iterator will be invalidated when we erase
-    // current_order_it (because they are iterators to the same element).
-    const internal::OrderMap::const_iterator new_hint =
-      ++internal::OrderMap::const_iterator(hint);
-    ordering.erase(current_order_it);
-    ordering.emplace_hint(new_hint, new_time, std::move(data_it));
-  }
-  else if (hint == ordering.end())
+  const std::size_t hint = arrays.lower_bound(new_time);
+  if (hint < arrays.size() && arrays.times[hint] == new_time)
   {
-    // This Waypoint must be moved to the end of the list.
-    segments.splice(segments.end(), segments, data_it);
-    ordering.erase(current_order_it);
-    ordering.emplace_hint(hint, new_time, std::move(data_it));
+    // The new time conflicts with an existing time, so we will throw an
+    // exception.
+    // *INDENT-OFF*
+    throw std::invalid_argument(
+      "[Trajectory::Waypoint::change_time] Attempted to set time to "
+      + std::to_string(new_time.time_since_epoch().count())
+      + "ns, but a waypoint already exists at that timestamp.");
+    // *INDENT-ON*
   }
-  else
-  {
-    const internal::WaypointList::const_iterator destination = hint->second;
-    assert(destination != segments.end());
 
-    if (destination->data.time == new_time)
-    {
-      // The new time conflicts with an existing time, so we will throw an
-      // exception.
-      // *INDENT-OFF*
-      throw std::invalid_argument(
-        "[Trajectory::Waypoint::change_time] Attempted to set time to "
-        + std::to_string(new_time.time_since_epoch().count())
-        + "ns, but a waypoint already exists at that timestamp.");
-      // *INDENT-ON*
-    }
-
-    segments.splice(destination, segments, data_it);
-    ordering.erase(current_order_it);
-    ordering.emplace_hint(hint, new_time, std::move(data_it));
-  }
+  // The hint is the index of the first waypoint that comes after new_time. If
+  // that waypoint currently comes after this one, then removing this waypoint
+  // will shift it down by one.
+  const std::size_t destination = current < hint ? hint - 1 : hint;
+  parent.move(current, destination);
 
-  // Update the time value in the data field.
-  current_data.time = new_time;
+  // Update the time value after the waypoint is in its new place.
+  arrays.times[destination] = new_time;
+  arrays.changed();
 
   return *this;
 }
@@ -357,22 +559,20 @@ Trajectory::Waypoint& Trajectory::Waypoint::change_time(const Time new_time)
 //==============================================================================
 void Trajectory::Waypoint::adjust_times(Duration delta_t)
 {
-  internal::WaypointList& segments = _pimpl->parent->segments;
-  const internal::WaypointList::iterator begin_it = _pimpl->myself;
-  const Time original_begin_time = begin_it->data.time;
+  internal::WaypointArrays& arrays = _pimpl->parent->arrays;
+  internal::WaypointVector<Time>& times = arrays.times;
+  const std::size_t begin = _pimpl->index();
 
-  if (delta_t.count() < 0 && begin_it != segments.begin())
+  if (delta_t.count() < 0 && begin > 0)
   {
     // If delta_t is negative and this is not the first Waypoint in the
     // Trajectory, make sure the change in time does not make it dip beneath its
     // predecessor Waypoint.
-    const internal::WaypointList::const_iterator predecessor_it =
-      --internal::WaypointList::iterator(begin_it);
-    const auto new_time = begin_it->data.time + delta_t;
-    if (new_time <= predecessor_it->data.time)
+    const Time predecessor_time = times[begin - 1];
+    const auto new_time = times[begin] + delta_t;
+    if (new_time <= predecessor_time)
     {
-      const auto tp = predecessor_it->data.time
-        .time_since_epoch().count();
+      const auto tp = predecessor_time.time_since_epoch().count();
       const auto tc = (new_time).time_since_epoch().count();
 
       const std::string error =
@@ -387,37 +587,17 @@ void Trajectory::Waypoint::adjust_times(Duration delta_t)
     }
   }
 
-  // Adjust the times for the segments and collect their iterators
-  std::vector<internal::WaypointList::iterator> list_iterators;
-  list_iterators.reserve(segments.size());
-  for (internal::WaypointList::iterator it = begin_it; it != segments.end();
-    ++it)
-  {
-    it->data.time += delta_t;
-    list_iterators.push_back(it);
-  }
-
-  internal::OrderMap& ordering = _pimpl->parent->ordering;
-  const internal::OrderMap::iterator order_it =
-    ordering.find(original_begin_time);
-  assert(order_it != ordering.end());
+  // Every waypoint from here to the end moves by the same amount, so their
+  // order does not change and nothing needs to be rearranged.
+  for (std::size_t i = begin; i < times.size(); ++i)
+    times[i] += delta_t;
 
-  // Erase the existing ordering entries for all the modified Trajectory
-  // Waypoints.
-  ordering.erase(order_it, ordering.end());
-
-  // Add new entries one at a time, supplying the emplacement operator with the
-  // hint that it can always append the entry to the end of the map.
-  for (internal::WaypointList::iterator& it : list_iterators)
-  {
-    const Time new_time = it->data.time;
-    ordering.emplace_hint(ordering.end(), new_time, std::move(it));
-  }
+  arrays.changed();
 }
 
 //==============================================================================
-Trajectory::Waypoint::Waypoint()
-: _pimpl(rmf_utils::make_impl<Implementation>())
+Trajectory::Waypoint::Waypoint(Implementation* const impl)
+: _pimpl(impl, &do_not_delete, &do_not_copy)
 {
   // Do nothing
 }
@@ -449,17 +629,13 @@ Trajectory::InsertionResult Trajectory::insert(
   Eigen::Vector3d position,
   Eigen::Vector3d velocity)
 {
-  return _pimpl->insert(
-    internal::WaypointElement::Data{
-      std::move(time),
-      std::move(position),
-      std::move(velocity)});
+  return _pimpl->insert(time, std::move(position), std::move(velocity));
 }
 
 //==============================================================================
 Trajectory::InsertionResult Trajectory::insert(const Waypoint& other)
 {
-  return _pimpl->insert(internal::WaypointElement::Data{other._pimpl->data()});
+  return _pimpl->insert(other.time(), other.position(), other.velocity());
 }
 
 //==============================================================================
@@ -471,7 +647,7 @@ Trajectory::iterator Trajectory::find(Time time)
 //==============================================================================
 Trajectory::const_iterator Trajectory::find(Time time) const
 {
-  return const_cast<Implementation&>(*_pimpl).find(time);
+  return _pimpl->find(time);
 }
 
 //==============================================================================
@@ -483,7 +659,7 @@ Trajectory::iterator Trajectory::lower_bound(Time time)
 //==============================================================================
 Trajectory::const_iterator Trajectory::lower_bound(Time time) const
 {
-  return const_cast<Implementation&>(*_pimpl).lower_bound(time);
+  return _pimpl->lower_bound(time);
 }
 
 //==============================================================================
@@ -507,13 +683,13 @@ Trajectory::iterator Trajectory::begin()
 //==============================================================================
 Trajectory::const_iterator Trajectory::begin() const
 {
-  return const_cast<Implementation&>(*_pimpl).begin();
+  return _pimpl->begin();
 }
 
 //==============================================================================
 Trajectory::const_iterator Trajectory::cbegin() const
 {
-  return const_cast<Implementation&>(*_pimpl).begin();
+  return _pimpl->begin();
 }
 
 //==============================================================================
@@ -525,87 +701,85 @@ Trajectory::iterator Trajectory::end()
 //==============================================================================
 Trajectory::const_iterator Trajectory::end() const
 {
-  return const_cast<Implementation&>(*_pimpl).end();
+  return _pimpl->end();
 }
 
 //==============================================================================
 Trajectory::const_iterator Trajectory::cend() const
 {
-  return const_cast<Implementation&>(*_pimpl).end();
+  return _pimpl->end();
 }
 
 //==============================================================================
 auto Trajectory::front() -> Waypoint&
 {
-  return *_pimpl->segments.front().myself;
+  return _pimpl->at(0);
 }
 
 //==============================================================================
 auto Trajectory::front() const -> const Waypoint&
 {
-  return *_pimpl->segments.front().myself;
+  return _pimpl->at(0);
 }
 
 //==============================================================================
 auto Trajectory::back() -> Waypoint&
 {
-  return *_pimpl->segments.back().myself;
+  return _pimpl->at(_pimpl->keys.size() - 1);
 }
 
 //==============================================================================
 auto Trajectory::back() const -> const Waypoint&
 {
-  return *_pimpl->segments.back().myself;
+  return _pimpl->at(_pimpl->keys.size() - 1);
 }
 
 //==============================================================================
 const Time* Trajectory::start_time() const
 {
-  const auto& segments = _pimpl->segments;
-  return segments.size() == 0 ? nullptr : &segments.front().data.time;
+  const auto& times = _pimpl->arrays.times;
+  return times.empty() ? nullptr : &times.front();
 }
 
 //==============================================================================
 const Time* Trajectory::finish_time() const
 {
-  const auto& segments = _pimpl->segments;
-  return segments.size() == 0 ? nullptr : &segments.back().data.time;
+  const auto& times = _pimpl->arrays.times;
+  return times.empty() ? nullptr : &times.back();
 }
 
 //==============================================================================
 Duration Trajectory::duration() const
 {
-  const auto& segments = _pimpl->segments;
-  return segments.size() < 2 ?
-    Duration(0) :
-    segments.back().data.time - segments.front().data.time;
+  const auto& times = _pimpl->arrays.times;
+  return times.size() < 2 ? Duration(0) : times.back() - times.front();
 }
 
 //==============================================================================
 std::size_t Trajectory::size() const
 {
-  return _pimpl->segments.size();
+  return _pimpl->arrays.size();
 }
 
 //==============================================================================
 template<typename SegT>
 SegT& Trajectory::base_iterator<SegT>::operator*() const
 {
-  return *_pimpl->raw_iterator->myself;
+  return _pimpl->parent->waypoint(_pimpl->key);
 }
 
 //==============================================================================
 template<typename SegT>
 SegT* Trajectory::base_iterator<SegT>::operator->() const
 {
-  return _pimpl->raw_iterator->myself.get();
+  return &_pimpl->parent->waypoint(_pimpl->key);
 }
 
 //==============================================================================
 template<typename SegT>
 auto Trajectory::base_iterator<SegT>::operator++() -> base_iterator&
 {
-  ++_pimpl->raw_iterator;
+  _pimpl->increment();
   return *this;
 }
 
@@ -613,7 +787,7 @@ auto Trajectory::base_iterator<SegT>::operator++() -> base_iterator&
 template<typename SegT>
 auto Trajectory::base_iterator<SegT>::operator--() -> base_iterator&
 {
-  --_pimpl->raw_iterator;
+  _pimpl->decrement();
   return *this;
 }
 
@@ -637,7 +811,7 @@ auto Trajectory::base_iterator<SegT>::operator--(int) -> base_iterator
   bool Trajectory::base_iterator<SegT>::operator op( \
     const base_iterator& other) const \
   { \
-    return _pimpl->raw_iterator op other._pimpl->raw_iterator; \
+    return _pimpl->key op other._pimpl->key; \
   }
 
 DEFINE_BASIC_ITERATOR_OP(==)
@@ -647,10 +821,8 @@ template<typename SegT>
 bool Trajectory::base_iterator<SegT>::operator<(
   const base_iterator& other) const
 {
-  const bool this_is_end =
-    this->_pimpl->raw_iterator == _pimpl->parent->segments.end();
-  const bool other_is_end =
-    other._pimpl->raw_iterator == _pimpl->parent->segments.end();
+  const bool this_is_end = this->_pimpl->is_end();
+  const bool other_is_end = other._pimpl->is_end();
 
   if (this_is_end || other_is_end)
   {
@@ -663,8 +835,7 @@ bool Trajectory::base_iterator<SegT>::operator<(
   }
 
   // If they are both valid iterators, then we can compare their times.
-  return this->_pimpl->raw_iterator->data.time
-    < other._pimpl->raw_iterator->data.time;
+  return this->_pimpl->time() < other._pimpl->time();
 }
 
 //==============================================================================
@@ -672,10 +843,8 @@ template<typename SegT>
 bool Trajectory::base_iterator<SegT>::operator>(
   const base_iterator& other) const
 {
-  const bool this_is_end =
-    this->_pimpl->raw_iterator == _pimpl->parent->segments.end();
-  const bool other_is_end =
-    other._pimpl->raw_iterator == _pimpl->parent->segments.end();
+  const bool this_is_end = this->_pimpl->is_end();
+  const bool other_is_end = other._pimpl->is_end();
 
   if (this_is_end || other_is_end)
   {
@@ -685,8 +854,7 @@ bool Trajectory::base_iterator<SegT>::operator>(
   }
 
   // If they are both valid iterators, then we can compare their times.
-  return this->_pimpl->raw_iterator->data.time
-    > other._pimpl->raw_iterator->data.time;
+  return this->_pimpl->time() > other._pimpl->time();
 }
 
 //==============================================================================
@@ -709,7 +877,7 @@ bool Trajectory::base_iterator<SegT>::operator>=(
 template<typename SegT>
 Trajectory::base_iterator<SegT>::operator const_iterator() const
 {
-  return _pimpl->make_iterator<const SegT>(_pimpl->raw_iterator);
+  return _pimpl->make_iterator<const SegT>(_pimpl->key);
 }
 
 //==============================================================================
@@ -730,57 +898,56 @@ bool Trajectory::Debug::check_iterator_time_consistency(
 {
   assert(trajectory._pimpl);
 
-  const internal::WaypointList& segments = trajectory._pimpl->segments;
-  const internal::OrderMap& ordering = trajectory._pimpl->ordering;
+  const Trajectory::Implementation& impl = *trajectory._pimpl;
+  const internal::WaypointArrays& arrays = impl.arrays;
 
   bool consistent = true;
-
-  internal::WaypointList::const_iterator s_it = segments.begin();
-  internal::OrderMap::const_iterator o_it = ordering.begin();
-  for ( ; s_it != segments.end() && o_it != ordering.end(); ++s_it, ++o_it)
+  consistent &= arrays.positions.size() == arrays.size();
+  consistent &= arrays.velocities.size() == arrays.size();
+  consistent &= impl.keys.size() == arrays.size();
+  const std::size_t inline_count =
+    std::min(impl.indices.size(), internal::InlineWaypoints);
+  consistent &= impl.extra_handles.size() == impl.indices.size() - inline_count;
+  consistent &=
+    impl.indices.size() == impl.keys.size() + impl.free_keys.size();
+
+  if (consistent)
   {
-    consistent &= s_it->data.time == o_it->first;
+    for (std::size_t i = 0; i < arrays.size(); ++i)
+    {
+      const std::size_t key = impl.keys[i];
+      consistent &= key < impl.indices.size() && impl.indices[key] == i;
+      if (i > 0)
+        consistent &= arrays.times[i-1] < arrays.times[i];
+    }
   }
 
-  consistent &= s_it == segments.end();
-  consistent &= o_it == ordering.end();
-
   if (print_inconsistency && !consistent)
   {
-    std::size_t index = 0;
-    s_it = segments.begin();
-    o_it = ordering.begin();
     std::cout << "Trajectory time inconsistency detected: "
-              << "( ordering | segments | difference )\n";
-    for ( ; s_it != segments.end() && o_it != ordering.end();
-      ++s_it, ++o_it, ++index)
+              << "( time | key | index of key )\n";
+    for (std::size_t i = 0; i < arrays.size(); ++i)
     {
-      const auto difference = o_it->first - s_it->data.time;
-      std::cout << " -- [" << index << "] "
-                << o_it->first.time_since_epoch().count()/1e9 << " | "
-                << s_it->data.time.time_since_epoch().count()/1e9
-                << " | Difference: " << difference.count()/1e9 << "\n";
-    }
-
-    if (s_it != segments.end())
-    {
-      std::cout << " -- more elements in segments\n";
-      for ( ; s_it != segments.end(); ++s_it, ++index)
+      std::cout << " -- [" << i << "] "
+                << arrays.times[i].time_since_epoch().count()/1e9;
+      if (i < impl.keys.size())
       {
-        std::cout << "      -- [" << index << "] "
-                  << s_it->data.time.time_since_epoch().count()/1e9
-                  << "\n";
-      }
-    }
-    if (o_it != ordering.end())
-    {
-      std::cout << " -- more elements in ordering:\n";
-      for ( ; o_it != ordering.end(); ++o_it, ++index)
-      {
-        std::cout << "     -- [" << index << "] "
-                  << o_it->first.time_since_epoch().count()/1e9 << "\n";
+        const std::size_t key = impl.keys[i];
+        std::cout << " | " << key << " | ";
+        if (key < impl.indices.size())
+          std::cout << impl.indices[key];
+        else
+          std::cout << "invalid key";
       }
+      std::cout << "\n";
     }
+
+    std::cout << " -- sizes: positions " << arrays.positions.size()
+              << " | velocities " << arrays.velocities.size()
+              << " | keys " << impl.keys.size()
+              << " | free keys " << impl.free_keys.size()
+              << " | all keys " << impl.indices.size()
+              << " | extra handles " << impl.extra_handles.size() << "\n";
     std::cout << std::endl;
   }
 
@@ -20,60 +20,99 @@
 
 #include <rmf_traffic/Trajectory.hpp>
 
-#include <list>
-#include <map>
+#include "SmallVector.hpp"
+
+#include <memory>
 
 namespace rmf_traffic {
 namespace internal {
 
 //==============================================================================
-struct WaypointElement;
-using WaypointList = std::list<WaypointElement>;
-using OrderMap = std::map<Time, WaypointList::iterator>;
+/// The number of waypoints that a Trajectory can hold before it needs to
+/// allocate any memory beyond its own implementation. Most of the trajectories
+/// that are produced while interpolating or planning have no more than this.
+const std::size_t InlineWaypoints = 8;
+
+//==============================================================================
+template<typename T>
+using WaypointVector = SmallVector<T, InlineWaypoints>;
+
+//==============================================================================
+/// Data about the segments of a Trajectory which is expensive to compute. This
+/// is defined in DetectConflictInternal.hpp.
+struct SegmentCache;
 
 //==============================================================================
-struct WaypointElement
+/// Structure-of-arrays storage for the waypoints of a Trajectory. Element i of
+/// each array belongs to the i-th waypoint in chronological order, so the
+/// times can be binary searched and a spline can be built from two adjacent
+/// entries without chasing any pointers.
+struct WaypointArrays
 {
-  struct Data
-  {
-    Time time;
-    Eigen::Vector3d position;
-    Eigen::Vector3d velocity;
-  };
+  WaypointVector<Time> times;
+  WaypointVector<Eigen::Vector3d> positions;
+  WaypointVector<Eigen::Vector3d> velocities;
 
-  Data data;
+  // This is filled in the first time that it is needed and cleared whenever
+  // the waypoints change. The cache itself is never modified, so copies of a
+  // Trajectory can share it. It may be filled in from several threads at once,
+  // so it must only be accessed with the std::atomic_* functions while the
+  // Trajectory is const.
+  mutable std::shared_ptr<const SegmentCache> segment_cache;
 
-  // We store a Trajectory::Waypoint in this struct so that we can always safely
-  // return a reference to a Trajectory::Waypoint object. As long as this
-  // WaypointData is alive, any Trajectory::Waypoint reference that refers to it
-  // will remain valid.
-  std::unique_ptr<Trajectory::Waypoint> myself;
+  WaypointArrays() = default;
 
-  WaypointElement(Data input_data)
-  : data(std::move(input_data))
+  WaypointArrays(const WaypointArrays& other)
+  : times(other.times),
+    positions(other.positions),
+    velocities(other.velocities),
+    segment_cache(std::atomic_load(&other.segment_cache))
   {
     // Do nothing
   }
 
-  WaypointElement(const WaypointElement& other)
-  : data(other.data)
+  WaypointArrays& operator=(const WaypointArrays& other)
   {
-    // Do nothing
+    times = other.times;
+    positions = other.positions;
+    velocities = other.velocities;
+    segment_cache = std::atomic_load(&other.segment_cache);
+    return *this;
   }
 
-  WaypointElement& operator=(const WaypointElement& other)
+  std::size_t size() const
   {
-    data = other.data;
-    return *this;
+    return times.size();
   }
 
-  WaypointElement(WaypointElement&&) = default;
-  WaypointElement& operator=(WaypointElement&&) = default;
+  /// This must be called whenever any of the waypoints are changed.
+  void changed()
+  {
+    segment_cache.reset();
+  }
+
+  /// Get the index of the first waypoint whose time is not earlier than the
+  /// given time. This will be size() if there is no such waypoint.
+  std::size_t lower_bound(Time time) const;
 };
 
 //==============================================================================
-WaypointList::const_iterator get_raw_iterator(
-  const Trajectory::const_iterator& iterator);
+/// A position within the WaypointArrays of a Trajectory
+struct RawIterator
+{
+  const WaypointArrays* arrays;
+  std::size_t index;
+};
+
+//==============================================================================
+RawIterator get_raw_iterator(const Trajectory::const_iterator& iterator);
+
+//==============================================================================
+/// Get an iterator to the waypoint at the given index of a trajectory. This
+/// will be the end iterator if the index is past the last waypoint.
+Trajectory::const_iterator get_iterator(
+  const Trajectory& trajectory,
+  std::size_t index);
 
 } // namespace internal
 } // namespace rmf_traffic
@@ -37,6 +37,7 @@ public:
   Graph graph;
   VehicleTraits traits;
   Interpolate::Options interpolation;
+  bool precompute_heuristics = false;
 
 };
 
@@ -114,6 +115,20 @@ const Interpolate::Options& Planner::Configuration::interpolation() const
   return _pimpl->interpolation;
 }
 
+//==============================================================================
+auto Planner::Configuration::precompute_heuristics(const bool precompute)
+-> Configuration&
+{
+  _pimpl->precompute_heuristics = precompute;
+  return *this;
+}
+
+//==============================================================================
+bool Planner::Configuration::precompute_heuristics() const
+{
+  return _pimpl->precompute_heuristics;
+}
+
 //==============================================================================
 class Planner::Options::Implementation
 {
@@ -454,6 +469,19 @@ auto Planner::get_default_options() const -> const Options&
   return _pimpl->default_options;
 }
 
+//==============================================================================
+void Planner::save_heuristics(std::ostream& output) const
+{
+  _pimpl->cache_mgr.save_heuristics(output);
+}
+
+//==============================================================================
+Planner& Planner::load_heuristics(std::istream& input)
+{
+  _pimpl->cache_mgr.load_heuristics(input);
+  return *this;
+}
+
 //==============================================================================
 Planner::Result Planner::plan(const Start& start, Goal goal) const
 {
@@ -905,5 +933,12 @@ auto Planner::Debug::begin(
     std::move(options));
 }
 
+//==============================================================================
+std::size_t Planner::Debug::pruned_node_count(const Planner::Result& result)
+{
+  return Result::Implementation::get(result).state.internal
+    ->pruned_node_count();
+}
+
 } // namespace agv
 } // namespace rmf_traffic
@@ -21,6 +21,40 @@
 namespace rmf_traffic {
 namespace agv {
 
+namespace {
+//==============================================================================
+/// Storage that is reused each time a NegotiatingRouteValidator looks for
+/// conflicts, so that checking a route does not need to allocate these vectors
+/// again once they have grown large enough. Each thread gets its own instance
+/// from thread_scratch(), so find_conflict() stays safe to call from many
+/// threads.
+struct ConflictScratch
+{
+  std::vector<DetectConflict::Other> others;
+  std::vector<schedule::ParticipantId> participants;
+
+  // The end caps of the rollouts
+  std::vector<Trajectory> end_caps;
+  std::vector<std::shared_ptr<const schedule::ParticipantDescription>>
+  descriptions;
+
+  void reset(const std::size_t expected_size = 0)
+  {
+    others.clear();
+    participants.clear();
+    others.reserve(expected_size);
+    participants.reserve(expected_size);
+  }
+};
+
+//==============================================================================
+ConflictScratch& thread_scratch()
+{
+  thread_local ConflictScratch instance;
+  return instance;
+}
+} // anonymous namespace
+
 //==============================================================================
 class ScheduleRouteValidator::Implementation
 {
@@ -79,34 +113,34 @@ schedule::ParticipantId ScheduleRouteValidator::participant() const
 rmf_utils::optional<RouteValidator::Conflict>
 ScheduleRouteValidator::find_conflict(const Route& route) const
 {
-  // TODO(MXG): Should we use a mutable Spacetime instance to avoid the
-  // allocation here?
-  schedule::Query::Spacetime spacetime;
-  spacetime.query_timespan()
-  .all_maps(false)
-  .add_map(route.map())
-  .set_lower_time_bound(*route.trajectory().start_time())
-  .set_upper_time_bound(*route.trajectory().finish_time());
-
-  const auto view = _pimpl->viewer->query(
-    spacetime, schedule::Query::Participants::make_all());
+  // The routes are visited straight out of the schedule so that we do not
+  // need to collect them into a View, and each one is checked as soon as it
+  // is found so that the search can stop at the first conflict.
+  const Implementation& impl = *_pimpl;
+  rmf_utils::optional<Conflict> conflict;
+  impl.viewer->visit(
+    route.map(),
+    *route.trajectory().start_time(),
+    *route.trajectory().finish_time(),
+    schedule::Query::Participants::make_all(),
+    [&impl, &route, &conflict](const schedule::Viewer::View::Element& v)
+    -> bool
+    {
+      if (v.participant == impl.participant)
+        return true;
 
-  for (const auto& v : view)
-  {
-    if (v.participant == _pimpl->participant)
-      continue;
+      if (const auto time = DetectConflict::between(
+          impl.profile, route.trajectory(),
+          v.description.profile(), v.route.trajectory()))
+      {
+        conflict = Conflict{v.participant, *time};
+        return false;
+      }
 
-    if (const auto time = rmf_traffic::DetectConflict::between(
-        _pimpl->profile,
-        route.trajectory(),
-        v.description.profile(),
-        v.route.trajectory()))
-    {
-      return Conflict{v.participant, *time};
-    }
-  }
+      return true;
+    });
 
-  return rmf_utils::nullopt;
+  return conflict;
 }
 
 //==============================================================================
@@ -281,17 +315,18 @@ bool NegotiatingRouteValidator::end() const
 rmf_utils::optional<RouteValidator::Conflict>
 NegotiatingRouteValidator::find_conflict(const Route& route) const
 {
-  // TODO(MXG): Consider if we can reduce the amount of heap allocation that's
-  // needed here.
-  schedule::Query::Spacetime spacetime;
-  spacetime.query_timespan()
-  .all_maps(false)
-  .add_map(route.map())
-  .set_lower_time_bound(*route.trajectory().start_time())
-  .set_upper_time_bound(*route.trajectory().finish_time());
-
-  const auto view = _pimpl->data->viewer->query(spacetime, _pimpl->rollouts);
-
+  const auto view = _pimpl->data->viewer->query(
+    route.map(),
+    *route.trajectory().start_time(),
+    *route.trajectory().finish_time(),
+    _pimpl->rollouts);
+
+  // All of the trajectories are gathered up first so that they can be checked
+  // against the route in one batch.
+  ConflictScratch& scratch = thread_scratch();
+  auto& others = scratch.others;
+  auto& participants = scratch.participants;
+  scratch.reset(view.size() + _pimpl->rollouts.size());
   for (const auto& v : view)
   {
     if (_pimpl->masked && (*_pimpl->masked == v.participant))
@@ -299,16 +334,19 @@ NegotiatingRouteValidator::find_conflict(const Route& route) const
 
     // NOTE(MXG): There is no need to check the map, because the query will
     // filter out all itineraries that are not on this map.
-    if (const auto time = rmf_traffic::DetectConflict::between(
-        _pimpl->data->profile,
-        route.trajectory(),
-        v.description.profile(),
-        v.route.trajectory()))
-    {
-      return Conflict{v.participant, *time};
-    }
+    others.push_back({&v.description.profile(), &v.route.trajectory()});
+    participants.push_back(v.participant);
   }
 
+  // The end caps need to stay in place while the batch is being checked, so
+  // we reserve enough space that they will never be reallocated.
+  auto& end_caps = scratch.end_caps;
+  auto& descriptions = scratch.descriptions;
+  end_caps.clear();
+  descriptions.clear();
+  end_caps.reserve(_pimpl->rollouts.size());
+  descriptions.reserve(_pimpl->rollouts.size());
+
   for (const auto& r : _pimpl->rollouts)
   {
     if (_pimpl->masked && (*_pimpl->masked == r.participant))
@@ -327,14 +365,16 @@ NegotiatingRouteValidator::find_conflict(const Route& route) const
     if (*route.trajectory().finish_time() < last_wp.time())
       continue;
 
-    const auto& description =
-      _pimpl->data->viewer->get_participant(r.participant);
+    descriptions.push_back(
+      _pimpl->data->viewer->get_participant(r.participant));
+    const auto& description = descriptions.back();
     assert(description);
 
     // The end_cap trajectory represents the last known position of the
     // rollout's alternative. This prevents the negotiator from using a
     // pathological strategy like waiting until the other participant vanishes.
-    Trajectory end_cap;
+    end_caps.emplace_back();
+    Trajectory& end_cap = end_caps.back();
     end_cap.insert(
       last_wp.time(),
       last_wp.position(),
@@ -345,14 +385,14 @@ NegotiatingRouteValidator::find_conflict(const Route& route) const
       last_wp.position(),
       Eigen::Vector3d::Zero());
 
-    if (const auto time = rmf_traffic::DetectConflict::between(
-        _pimpl->data->profile,
-        route.trajectory(),
-        description->profile(),
-        end_cap))
-    {
-      return Conflict{r.participant, *time};
-    }
+    others.push_back({&description->profile(), &end_cap});
+    participants.push_back(r.participant);
+  }
+
+  if (const auto conflict = DetectConflict::between_many(
+      _pimpl->data->profile, route.trajectory(), others))
+  {
+    return Conflict{participants[conflict->index], conflict->time};
   }
 
   return rmf_utils::nullopt;
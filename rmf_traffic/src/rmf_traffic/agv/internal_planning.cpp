@@ -26,10 +26,16 @@
 
 #include <rmf_traffic/DetectConflict.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include <queue>
+#include <type_traits>
 
 namespace rmf_traffic {
 namespace internal {
@@ -51,73 +57,133 @@ struct Compare
 };
 
 //==============================================================================
-Cache::Cache(const Cache&)
+// Orders nodes the same way as Compare, but when two nodes are equally
+// promising, the node that was created first leaves the queue first. Otherwise
+// the order of tied nodes would depend on the layout of the heap, and pruning
+// a node could change which of two equally good plans gets found.
+template<typename NodePtr>
+struct CompareWithSequence
 {
-  // Do nothing
-}
+  bool operator()(const NodePtr& a, const NodePtr& b)
+  {
+    const double cost_a = a->remaining_cost_estimate + a->current_cost;
+    const double cost_b = b->remaining_cost_estimate + b->current_cost;
+    if (cost_a == cost_b)
+      return b->sequence < a->sequence;
 
-//==============================================================================
-Cache::Cache(Cache&&)
-{
-  // Do nothing
-}
+    return cost_b < cost_a;
+  }
+};
 
 //==============================================================================
-Cache& Cache::operator=(const Cache&)
+// A monotonic arena for search nodes. Nodes are constructed inside of blocks
+// that grow geometrically. They are never freed one at a time; they are all
+// destroyed together when the arena is destroyed, so a node pointer stays
+// valid for as long as its arena is alive.
+//
+// An arena can keep an older arena alive, which lets the nodes that it creates
+// refer to parent nodes that live in the older arena.
+template<typename T>
+class NodeArena
 {
-  // Do nothing
-  return *this;
-}
+public:
 
-//==============================================================================
-Cache& Cache::operator=(Cache&&)
-{
-  // Do nothing
-  return *this;
-}
+  NodeArena(std::shared_ptr<const NodeArena> previous = nullptr)
+  : _count(previous ? previous->_count : 0),
+    _previous(std::move(previous))
+  {
+    // Do nothing
+  }
+
+  // Node pointers refer into the arena, so it can be neither copied nor moved
+  NodeArena(const NodeArena&) = delete;
+  NodeArena& operator=(const NodeArena&) = delete;
+
+  template<typename... Args>
+  T* make(Args&& ... args)
+  {
+    if (_blocks.empty() || _used == _blocks.back().capacity)
+    {
+      const std::size_t initial_capacity = 64;
+      const std::size_t max_capacity = 4096;
+      const std::size_t capacity = _blocks.empty() ?
+        initial_capacity : std::min(2*_blocks.back().capacity, max_capacity);
+
+      _blocks.push_back(
+        Block{std::unique_ptr<Storage[]>(new Storage[capacity]), capacity});
+      _used = 0;
+    }
+
+    T* const object = reinterpret_cast<T*>(&_blocks.back().storage[_used]);
+    new (object) T(std::forward<Args>(args)...);
+    ++_used;
+    ++_count;
+    return object;
+  }
+
+  // The number of objects that were made by this arena and the arenas that it
+  // continues from
+  std::size_t size() const
+  {
+    return _count;
+  }
+
+  ~NodeArena()
+  {
+    for (std::size_t b = 0; b < _blocks.size(); ++b)
+    {
+      const Block& block = _blocks[b];
+      const std::size_t count = b+1 == _blocks.size() ? _used : block.capacity;
+      for (std::size_t i = 0; i < count; ++i)
+        reinterpret_cast<T*>(&block.storage[i])->~T();
+    }
+  }
+
+private:
+
+  using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  struct Block
+  {
+    std::unique_ptr<Storage[]> storage;
+    std::size_t capacity;
+  };
+
+  std::vector<Block> _blocks;
+  std::size_t _used = 0;
+  std::size_t _count;
+  std::shared_ptr<const NodeArena> _previous;
+};
 
 //==============================================================================
-CacheHandle::CacheHandle(CachePtr original)
-: _original(std::move(original))
+CacheHandle::CacheHandle(CachePtr cache)
+: _cache(std::move(cache))
 {
-  std::unique_lock<std::mutex> lock(_original->mutex);
-  _copy = _original->clone();
+  // Do nothing
 }
 
 //==============================================================================
 Cache* CacheHandle::operator->()
 {
-  return _copy.get();
+  return _cache.get();
 }
 
 //==============================================================================
 const Cache* CacheHandle::operator->() const
 {
-  return _copy.get();
+  return _cache.get();
 }
 
 //==============================================================================
 Cache& CacheHandle::operator*() &
 {
-  return *_copy.get();
+  return *_cache.get();
 }
 
 //==============================================================================
 const Cache& CacheHandle::operator*() const&
 {
-  return *_copy.get();
-}
-
-//==============================================================================
-CacheHandle::~CacheHandle()
-{
-  if (!_original)
-    return;
-
-  // We are now done with the copy, so we will update the original cache with
-  // whatever new searches have been accomplished by the copy.
-  std::unique_lock<std::mutex> lock(_original->mutex);
-  _original->update(*_copy);
+  return *_cache.get();
 }
 
 //==============================================================================
@@ -139,6 +205,24 @@ const agv::Planner::Configuration& CacheManager::get_configuration() const
   return _cache->get_configuration();
 }
 
+//==============================================================================
+void CacheManager::precompute_heuristics()
+{
+  _cache->precompute_heuristics();
+}
+
+//==============================================================================
+void CacheManager::save_heuristics(std::ostream& output) const
+{
+  _cache->save_heuristics(output);
+}
+
+//==============================================================================
+void CacheManager::load_heuristics(std::istream& input)
+{
+  _cache->load_heuristics(input);
+}
+
 //==============================================================================
 template<
   class Expander,
@@ -609,7 +693,9 @@ const Eigen::Rotation2Dd DifferentialDriveConstraint::R_pi =
 struct DifferentialDriveExpander
 {
   struct Node;
-  using NodePtr = std::shared_ptr<Node>;
+
+  // Nodes are owned by the Arena of the search that created them
+  using NodePtr = Node*;
 
   struct Node
   {
@@ -622,10 +708,16 @@ struct DifferentialDriveExpander
     NodePtr parent;
     rmf_utils::optional<agv::Plan::Start> start = rmf_utils::nullopt;
     rmf_utils::optional<std::size_t> start_set_index = rmf_utils::nullopt;
+
+    // The order in which the node was created, used to break ties
+    std::size_t sequence = 0;
   };
 
-  using SearchQueue =
-    std::priority_queue<NodePtr, std::vector<NodePtr>, Compare<NodePtr>>;
+  using Arena = NodeArena<Node>;
+  using ArenaPtr = std::shared_ptr<Arena>;
+
+  using SearchQueue = std::priority_queue<
+    NodePtr, std::vector<NodePtr>, CompareWithSequence<NodePtr>>;
 
   class LaneEventExecutor : public agv::Graph::Lane::Executor
   {
@@ -711,78 +803,544 @@ struct DifferentialDriveExpander
     const agv::Planner::StartSet& starts;
   };
 
+  // The heuristic tables for one goal waypoint. A single Heuristic is shared
+  // by every planning thread that plans towards its goal. Each table is
+  // computed the first time it is needed and then published with the
+  // std::atomic_* shared_ptr functions. A published table is never modified,
+  // so readers never need to lock anything.
   class Heuristic
   {
   public:
 
+    using Table = std::vector<double>;
+    using TablePtr = std::shared_ptr<const Table>;
+
+    TablePtr translation_costs(const Context& context)
+    {
+      return get_or_compute(_translation, [&]()
+        {
+          return compute_costs(
+            context.graph, context.traits, context.final_waypoint);
+        });
+    }
+
+    TablePtr rotation_costs(const Context& context, const int goal_bin)
+    {
+      return get_or_compute(
+        _rotation[static_cast<std::size_t>(goal_bin + 1)], [&]()
+        {
+          return compute_rotation_costs(
+            context.graph,
+            context.traits,
+            context.interpolate.rotation_thresh,
+            context.final_waypoint,
+            goal_bin);
+        });
+    }
+
+    // The number of bins that headings are sorted into for the rotation
+    // estimates. Each bin spans 15 degrees.
+    static constexpr std::size_t HeadingBins = 24;
+
+    static double heading_bin_width()
+    {
+      return 2.0*M_PI/static_cast<double>(HeadingBins);
+    }
+
+    static std::size_t heading_bin(const double orientation)
+    {
+      const double offset = rmf_utils::wrap_to_pi(orientation) + M_PI;
+      const auto bin =
+        static_cast<std::size_t>(std::floor(offset/heading_bin_width()));
+      return std::min(bin, HeadingBins-1);
+    }
+
+    static double heading_bin_center(const std::size_t bin)
+    {
+      return -M_PI + (static_cast<double>(bin) + 0.5)*heading_bin_width();
+    }
+
+    // A lower bound on the time needed to rotate from one heading to another.
+    // The difference between the headings is reduced by the slack before the
+    // duration is computed, so that a heading which is only known to within
+    // a bin still produces an admissible estimate. A NaN heading means that
+    // the heading is not constrained, so no rotation is needed.
+    static double rotation_time(
+      const agv::VehicleTraits& traits,
+      const double rotation_thresh,
+      const double from,
+      const double to,
+      const double slack = 0.0)
+    {
+      if (std::isnan(from) || std::isnan(to))
+        return 0.0;
+
+      const double diff = std::max(
+        0.0, std::abs(rmf_utils::wrap_to_pi(to - from)) - slack);
+
+      // Rotations smaller than the threshold get skipped when interpolating
+      if (diff < rotation_thresh)
+        return 0.0;
+
+      // This matches the trapezoidal motion profile that is used by
+      // agv::internal::interpolate_rotation.
+      const double w = traits.rotational().get_nominal_velocity();
+      const double alpha = traits.rotational().get_nominal_acceleration();
+      if (diff < w*w/alpha)
+        return 2.0*std::sqrt(diff/alpha);
+
+      return diff/w + w/alpha;
+    }
+
+    // Compute a lower bound on the time that the vehicle must spend rotating
+    // in place while it travels from each (waypoint, heading bin) to the goal.
+    //
+    // The states of a reverse Dijkstra search are (lane, orientation) pairs,
+    // using the orientations that the DifferentialDriveConstraint allows for
+    // each lane. The cost to go of a state is the least amount of rotation
+    // needed after entering that lane. Lane orientation constraints are
+    // ignored, which can only make the estimate smaller. The rotation time is
+    // added to the translation estimate, which stays admissible because each
+    // of them is a lower bound over every path to the goal.
+    //
+    // When goal_bin is non-negative, the vehicle must also finish within that
+    // heading bin.
+    static std::vector<double> compute_rotation_costs(
+      const agv::Graph::Implementation& graph,
+      const agv::VehicleTraits& traits,
+      const double rotation_thresh,
+      const std::size_t goal_waypoint,
+      const int goal_bin)
+    {
+      const double inf = std::numeric_limits<double>::infinity();
+      const std::size_t N = graph.waypoints.size();
+      std::vector<double> costs(N*HeadingBins, inf);
+      if (goal_waypoint >= N)
+        return costs;
+
+      const double half_bin = 0.5*heading_bin_width();
+      const double goal_heading = goal_bin < 0 ?
+        std::numeric_limits<double>::quiet_NaN() :
+        heading_bin_center(static_cast<std::size_t>(goal_bin));
+
+      const auto* differential = traits.get_differential();
+      assert(differential);
+      DifferentialDriveConstraint constraint(
+        differential->get_forward(), differential->is_reversible());
+
+      struct LaneState
+      {
+        std::size_t lane;
+        double orientation;
+      };
+
+      std::vector<LaneState> states;
+      std::vector<std::vector<std::size_t>> states_of_lane(graph.lanes.size());
+      std::vector<std::vector<std::size_t>> lanes_into(N);
+      for (std::size_t l = 0; l < graph.lanes.size(); ++l)
+      {
+        const agv::Graph::Lane& lane = graph.lanes[l];
+        lanes_into[lane.exit().waypoint_index()].push_back(l);
+
+        const Eigen::Vector2d course =
+          graph.waypoints[lane.exit().waypoint_index()].get_location()
+          - graph.waypoints[lane.entry().waypoint_index()].get_location();
+
+        if (course.norm() < 1e-8)
+        {
+          // Lanes that do not move the vehicle (e.g. lifts) do not constrain
+          // its heading.
+          states_of_lane[l].push_back(states.size());
+          states.push_back({l, std::numeric_limits<double>::quiet_NaN()});
+          continue;
+        }
+
+        for (const double orientation :
+          constraint.get_orientations(course.normalized()))
+        {
+          states_of_lane[l].push_back(states.size());
+          states.push_back({l, orientation});
+        }
+      }
+
+      std::vector<double> state_costs(states.size(), inf);
+
+      using QueueEntry = std::pair<double, std::size_t>;
+      std::priority_queue<
+        QueueEntry,
+        std::vector<QueueEntry>,
+        std::greater<QueueEntry>
+      > queue;
+
+      for (const std::size_t l : lanes_into[goal_waypoint])
+      {
+        for (const std::size_t s : states_of_lane[l])
+        {
+          const double cost = rotation_time(
+            traits, rotation_thresh,
+            states[s].orientation, goal_heading, half_bin);
+
+          if (cost < state_costs[s])
+          {
+            state_costs[s] = cost;
+            queue.push({cost, s});
+          }
+        }
+      }
+
+      while (!queue.empty())
+      {
+        const QueueEntry top = queue.top();
+        queue.pop();
+
+        const std::size_t s = top.second;
+        if (state_costs[s] < top.first)
+          continue;
+
+        const double orientation = states[s].orientation;
+        const std::size_t entry =
+          graph.lanes[states[s].lane].entry().waypoint_index();
+
+        for (const std::size_t l : lanes_into[entry])
+        {
+          for (const std::size_t prev : states_of_lane[l])
+          {
+            const double cost = top.first + rotation_time(
+              traits, rotation_thresh, states[prev].orientation, orientation);
+
+            if (cost < state_costs[prev])
+            {
+              state_costs[prev] = cost;
+              queue.push({cost, prev});
+            }
+          }
+        }
+      }
+
+      for (std::size_t wp = 0; wp < N; ++wp)
+      {
+        for (std::size_t bin = 0; bin < HeadingBins; ++bin)
+        {
+          const double heading = heading_bin_center(bin);
+          double& cost = costs[wp*HeadingBins + bin];
+
+          if (wp == goal_waypoint)
+          {
+            cost = rotation_time(
+              traits, rotation_thresh, heading, goal_heading, 2.0*half_bin);
+          }
+
+          for (const std::size_t l : graph.lanes_from[wp])
+          {
+            for (const std::size_t s : states_of_lane[l])
+            {
+              cost = std::min(cost, state_costs[s] + rotation_time(
+                  traits, rotation_thresh,
+                  heading, states[s].orientation, half_bin));
+            }
+          }
+        }
+      }
+
+      return costs;
+    }
+
+    // Compute the estimated cost of travelling from every waypoint in the
+    // graph to the goal waypoint.
+    //
+    // A single reverse Dijkstra search from the goal finds the shortest
+    // Euclidean path (plus lane event durations) from each waypoint. The
+    // estimate for a waypoint is the duration of a trajectory interpolated
+    // along that path, which is the same value that a forward
+    // EuclideanExpander search from the waypoint would produce. Waypoints that
+    // cannot reach the goal are given an infinite cost.
+    static std::vector<double> compute_costs(
+      const agv::Graph::Implementation& graph,
+      const agv::VehicleTraits& traits,
+      const std::size_t goal_waypoint)
+    {
+      const std::size_t N = graph.waypoints.size();
+      std::vector<double> costs(N, std::numeric_limits<double>::infinity());
+      if (goal_waypoint >= N)
+        return costs;
+
+      std::vector<std::vector<std::size_t>> lanes_into(N);
+      for (std::size_t l = 0; l < graph.lanes.size(); ++l)
+        lanes_into[graph.lanes[l].exit().waypoint_index()].push_back(l);
+
+      // The distance of each waypoint from the goal, and the next waypoint to
+      // visit along the shortest path towards the goal.
+      std::vector<double> distance(N, std::numeric_limits<double>::infinity());
+      std::vector<std::size_t> next(N, N);
+      std::vector<std::size_t> settled;
+      settled.reserve(N);
+
+      using QueueEntry = std::pair<double, std::size_t>;
+      std::priority_queue<
+        QueueEntry,
+        std::vector<QueueEntry>,
+        std::greater<QueueEntry>
+      > queue;
+
+      distance[goal_waypoint] = 0.0;
+      queue.push({0.0, goal_waypoint});
+      while (!queue.empty())
+      {
+        const QueueEntry top = queue.top();
+        queue.pop();
+
+        const std::size_t wp = top.second;
+        if (distance[wp] < top.first)
+          continue;
+
+        settled.push_back(wp);
+        const Eigen::Vector2d p_wp = graph.waypoints[wp].get_location();
+        for (const std::size_t l : lanes_into[wp])
+        {
+          const agv::Graph::Lane& lane = graph.lanes[l];
+          const std::size_t entry = lane.entry().waypoint_index();
+          const Eigen::Vector2d p_entry =
+            graph.waypoints[entry].get_location();
+
+          const double cost = top.first
+            + EuclideanExpander::lane_event_cost(lane)
+            + (p_wp - p_entry).norm();
+
+          if (cost < distance[entry])
+          {
+            distance[entry] = cost;
+            next[entry] = wp;
+            queue.push({cost, entry});
+          }
+        }
+      }
+
+      costs[goal_waypoint] = 0.0;
+      std::vector<Eigen::Vector3d> positions;
+      for (const std::size_t wp : settled)
+      {
+        if (wp == goal_waypoint)
+          continue;
+
+        positions.clear();
+        for (std::size_t w = wp; w < N; w = next[w])
+        {
+          const Eigen::Vector2d p = graph.waypoints[w].get_location();
+          positions.push_back({p[0], p[1], 0.0});
+        }
+
+        // We don't care about the Trajectory's start/end time being correct;
+        // we only care about the difference between the two.
+        const rmf_traffic::Trajectory estimate = agv::Interpolate::positions(
+          traits, rmf_traffic::Time(rmf_traffic::Duration(0)), positions);
+
+        costs[wp] = time::to_seconds(estimate.duration());
+      }
+
+      return costs;
+    }
+
+    // Get the translation table if it has been computed, or nullptr.
+    TablePtr costs() const
+    {
+      return std::atomic_load(&_translation);
+    }
+
+    void set_costs(Table costs)
+    {
+      std::atomic_store(
+        &_translation, TablePtr(std::make_shared<Table>(std::move(costs))));
+    }
+
+  private:
+
+    template<typename Compute>
+    static TablePtr get_or_compute(TablePtr& slot, const Compute& compute)
+    {
+      TablePtr table = std::atomic_load(&slot);
+      if (table)
+        return table;
+
+      // If another thread publishes the same table while we are computing
+      // ours, we use theirs so that every reader agrees on a single table.
+      TablePtr expected = nullptr;
+      table = std::make_shared<Table>(compute());
+      if (std::atomic_compare_exchange_strong(&slot, &expected, table))
+        return table;
+
+      return expected;
+    }
+
+    TablePtr _translation;
+
+    // Rotation estimates for each (waypoint, heading bin). The slot at index 0
+    // is for goals without an orientation, and the slot at index b+1 is for
+    // goal orientations in heading bin b.
+    std::array<TablePtr, HeadingBins+1> _rotation;
+  };
+
+  // A planning thread's view of a shared Heuristic. It holds on to the tables
+  // that it has loaded, so each search only touches the shared atomics once
+  // per table.
+  class HeuristicView
+  {
+  public:
+
+    HeuristicView(Heuristic& shared)
+    : _shared(&shared)
+    {
+      // Do nothing
+    }
+
     double estimate_remaining_cost(
       const Context& context,
       const std::size_t waypoint)
     {
-      auto estimate_it = known_costs.insert(
-        {waypoint, std::numeric_limits<double>::infinity()});
+      if (!_translation)
+        _translation = _shared->translation_costs(context);
+
+      return (*_translation)[waypoint];
+    }
+
+    // This estimate also accounts for the time that the vehicle will need to
+    // spend rotating in place before it can arrive at the goal.
+    double estimate_remaining_cost(
+      const Context& context,
+      const std::size_t waypoint,
+      const double orientation)
+    {
+      const double translation = estimate_remaining_cost(context, waypoint);
+      if (!std::isfinite(translation))
+        return translation;
 
-      if (estimate_it.second)
+      if (!_rotation)
       {
-        // The pair was inserted, which implies that the cost estimate for this
-        // waypoint has never been found before, and we should compute it now.
-        auto euclidean_context = EuclideanExpander::Context{
-          context.graph,
-          context.final_waypoint
-        };
-        EuclideanExpander expander(euclidean_context);
-
-        EuclideanExpander::SearchQueue euclidean_queue;
-        expander.make_initial_nodes(
-          EuclideanExpander::InitialNodeArgs{waypoint},
-          euclidean_queue);
-
-        const EuclideanExpander::NodePtr solution =
-          search<EuclideanExpander>(expander, euclidean_queue, nullptr);
-
-        // TODO(MXG): Instead of asserting that the goal exists, we should
-        // probably take this opportunity to shortcircuit the planner and return
-        // that there is no solution.
-        assert(solution != nullptr);
-
-        std::vector<Eigen::Vector3d> positions;
-        EuclideanExpander::NodePtr euclidean_node = solution;
-        // Note: this constructs positions in reverse, but that's okay because
-        // the Interpolate::positions function will produce a trajectory with the
-        // same duration whether it is interpolating forward or backwards.
-        while (euclidean_node)
+        int goal_bin = -1;
+        if (context.final_orientation)
         {
-          const Eigen::Vector2d p = euclidean_node->location;
-          positions.push_back({p[0], p[1], 0.0});
-          euclidean_node = euclidean_node->parent;
+          goal_bin = static_cast<int>(
+            Heuristic::heading_bin(*context.final_orientation));
         }
 
-        // We pass in context.initial_time here because we don't actually care
-        // about the Trajectory's start/end time being correct; we only care
-        // about the difference between the two.
-        const rmf_traffic::Trajectory estimate = agv::Interpolate::positions(
-          context.traits, context.initial_time, positions);
+        _rotation = _shared->rotation_costs(context, goal_bin);
+      }
+
+      return translation + (*_rotation)[
+        waypoint*Heuristic::HeadingBins + Heuristic::heading_bin(orientation)];
+    }
+
+  private:
+    Heuristic* _shared;
+    Heuristic::TablePtr _translation;
+    Heuristic::TablePtr _rotation;
+  };
+
+  // Remembers the states that a search has already expanded, so that nodes
+  // which reach the same state again at a higher cost can be dropped instead
+  // of being expanded again.
+  class DominanceMap
+  {
+  public:
+
+    struct Key
+    {
+      std::size_t waypoint;
+      std::size_t heading_bin;
 
-        const double cost_esimate = time::to_seconds(estimate.duration());
-        estimate_it.first->second = cost_esimate;
+      // The arrival time, which is only part of the key when the search uses a
+      // route validator. Otherwise this is always zero.
+      Duration::rep time;
 
-        // TODO(MXG): We could get significantly better performance if we
-        // accounted for the cost of rotating when making this estimate, but
-        // that would add considerable complexity to the caching, so we'll leave
-        // that for a future improvement.
+      bool operator==(const Key& other) const
+      {
+        return waypoint == other.waypoint
+          && heading_bin == other.heading_bin
+          && time == other.time;
+      }
+    };
+
+    struct KeyHash
+    {
+      std::size_t operator()(const Key& key) const
+      {
+        const std::size_t h =
+          key.waypoint*Heuristic::HeadingBins + key.heading_bin;
+        return h ^ (std::hash<Duration::rep>()(key.time)
+          + 0x9e3779b9 + (h << 6) + (h >> 2));
+      }
+    };
+
+    struct Entry
+    {
+      double orientation;
+      Time time;
+      double cost;
+
+      // Lane orientations are discrete, so only exactly equal orientations
+      // are treated as the same state. Exact ties do not dominate each other,
+      // because which of two tied nodes gets expanded first depends on the
+      // layout of the queue, and pruning either one could change the plan.
+      bool dominates(const Entry& other) const
+      {
+        return orientation == other.orientation
+          && time <= other.time
+          && cost <= other.cost
+          && (time < other.time || cost < other.cost);
+      }
+
+      bool operator==(const Entry& other) const
+      {
+        return orientation == other.orientation
+          && time == other.time
+          && cost == other.cost;
       }
+    };
 
-      return estimate_it.first->second;
+    // Each key only holds entries that do not dominate each other, so waiting
+    // at a waypoint for a long time does not make these lists grow.
+    std::unordered_map<Key, std::vector<Entry>, KeyHash> expanded;
+
+    // The number of nodes that were dropped because they were dominated
+    std::size_t pruned = 0;
+
+    static Key key(
+      const std::size_t waypoint,
+      const double orientation,
+      const Duration::rep time)
+    {
+      return Key{waypoint, Heuristic::heading_bin(orientation), time};
     }
 
-    void update(const Heuristic& other)
+    bool dominated(const Key& key, const Entry& candidate) const
     {
-      for (const auto& wp_costs : other.known_costs)
-        known_costs.insert(wp_costs);
+      const auto it = expanded.find(key);
+      if (it == expanded.end())
+        return false;
+
+      for (const auto& entry : it->second)
+      {
+        if (entry.dominates(candidate))
+          return true;
+      }
+
+      return false;
     }
 
-  private:
-    std::unordered_map<std::size_t, double> known_costs;
+    void insert(const Key& key, const Entry& entry)
+    {
+      auto& entries = expanded[key];
+      entries.erase(
+        std::remove_if(
+          entries.begin(), entries.end(),
+          [&entry](const Entry& other)
+          {
+            return entry.dominates(other);
+          }),
+        entries.end());
+
+      if (std::find(entries.begin(), entries.end(), entry) == entries.end())
+        entries.push_back(entry);
+    }
   };
 
   struct Context
@@ -796,9 +1354,11 @@ struct DifferentialDriveExpander
     const std::size_t final_waypoint;
     const rmf_utils::optional<double> final_orientation;
     const bool* const interrupt_flag;
-    Heuristic& heuristic;
+    HeuristicView heuristic;
     Issues::BlockerMap& blockers;
     const bool simple_lane_expansion; // reduces branching factor when true
+    const ArenaPtr arena; // new nodes are created in this arena
+    DominanceMap* const dominance; // nullptr disables dominance pruning
     const rmf_traffic::Time initial_time = rmf_traffic::Time(
       rmf_traffic::Duration(0));
   };
@@ -929,10 +1489,6 @@ struct DifferentialDriveExpander
 
     const std::size_t waypoint = start_node->start->waypoint();
 
-    const double remaining_cost_estimate =
-      _context.heuristic.estimate_remaining_cost(_context,
-        waypoint);
-
     for (const auto& route : routes)
     {
       const double current_cost =
@@ -943,13 +1499,16 @@ struct DifferentialDriveExpander
       if (!is_valid(route, start_node))
         continue;
 
+      const double orientation = route.trajectory.back().position()[2];
+
 //      std::cout << "Expanding down lane from start" << std::endl;
-      queue.push(std::make_shared<Node>(
+      queue.push(make_node(
           Node{
-            remaining_cost_estimate,
+            _context.heuristic.estimate_remaining_cost(
+              _context, waypoint, orientation),
             current_cost,
             waypoint,
-            route.trajectory.back().position()[2],
+            orientation,
             route,
             nullptr,
             start_node
@@ -973,7 +1532,7 @@ struct DifferentialDriveExpander
     if (is_valid(wait_route, start_node))
     {
 //      std::cout << "Expanding hold from start" << std::endl;
-      queue.push(std::make_shared<Node>(
+      queue.push(make_node(
           Node{
             start_node->remaining_cost_estimate,
             wait_cost,
@@ -1005,17 +1564,24 @@ struct DifferentialDriveExpander
       const auto& start = args.starts[start_index];
       const std::size_t initial_waypoint = start.waypoint();
       auto initial_routes = make_start_approach_routes(start);
-      const double remaining_cost_estimate =
-        _context.heuristic.estimate_remaining_cost(_context,
-          initial_waypoint);
 
-      double shortest_route_cost = initial_routes.empty() ?
-        0.0 : std::numeric_limits<double>::infinity();
+      // The start node will be expanded into one of its approach routes, so
+      // the cheapest of those gives the estimate. A start without any approach
+      // routes is already on its waypoint.
+      double remaining_cost_estimate = initial_routes.empty() ?
+        _context.heuristic.estimate_remaining_cost(
+          _context, initial_waypoint, start.orientation()) :
+        std::numeric_limits<double>::infinity();
       for (const auto& initial_route : initial_routes)
       {
         const double route_cost =
           rmf_traffic::time::to_seconds(initial_route.trajectory.duration());
-        shortest_route_cost = std::min(shortest_route_cost, route_cost);
+        const double orientation =
+          initial_route.trajectory.back().position()[2];
+        remaining_cost_estimate = std::min(
+          remaining_cost_estimate,
+          route_cost + _context.heuristic.estimate_remaining_cost(
+            _context, initial_waypoint, orientation));
       }
 
       const auto& wp = _context.graph.waypoints[initial_waypoint];
@@ -1041,9 +1607,9 @@ struct DifferentialDriveExpander
       if (!start.location())
         start_node_wp = initial_waypoint;
 
-      queue.push(std::make_shared<Node>(
+      queue.push(make_node(
           Node{
-            shortest_route_cost + remaining_cost_estimate,
+            remaining_cost_estimate,
             0.0,
             start_node_wp,
             start.orientation(),
@@ -1056,6 +1622,12 @@ struct DifferentialDriveExpander
     }
   }
 
+  NodePtr make_node(Node node)
+  {
+    node.sequence = _context.arena->size();
+    return _context.arena->make(std::move(node));
+  }
+
   bool is_finished(const NodePtr& node) const
   {
     if (!node->waypoint)
@@ -1085,9 +1657,12 @@ struct DifferentialDriveExpander
 
       if (conflict)
       {
+        // The key shares ownership of the arena, which keeps the parent node
+        // alive for as long as the blocker is remembered.
         auto time_it =
           _context.blockers[conflict->participant]
-          .insert({parent, conflict->time});
+          .insert({std::shared_ptr<void>(_context.arena, parent),
+              conflict->time});
 
         if (!time_it.second)
         {
@@ -1130,9 +1705,10 @@ struct DifferentialDriveExpander
 
     if (is_valid(route, parent_node))
     {
-      return std::make_shared<Node>(
+      return make_node(
         Node{
-          _context.heuristic.estimate_remaining_cost(_context, waypoint),
+          _context.heuristic.estimate_remaining_cost(
+            _context, waypoint, target_orientation),
           compute_current_cost(parent_node, trajectory),
           waypoint,
           target_orientation,
@@ -1225,9 +1801,10 @@ struct DifferentialDriveExpander
     assert(route.trajectory.size() > 1);
     if (is_valid(route, parent_node))
     {
-      return std::make_shared<Node>(
+      return make_node(
         Node{
-          _context.heuristic.estimate_remaining_cost(_context, waypoint),
+          _context.heuristic.estimate_remaining_cost(
+            _context, waypoint, orientation),
           compute_current_cost(parent_node, route.trajectory),
           waypoint,
           orientation,
@@ -1260,13 +1837,58 @@ struct DifferentialDriveExpander
       // TODO(MXG): Consider short-circuiting the rest of the search and
       // returning the solution if this Node solves the search problem. It could
       // be an optional behavior configurable from the Planner::Options.
-      queue.push(node);
+      push_if_not_dominated(node, queue);
       return true;
     }
 
     return false;
   }
 
+  // Get the key that the dominance map uses for a node. Without a validator
+  // the search does not depend on time, so a state that was reached earlier
+  // and at a lower cost dominates the node. With a validator, arriving later
+  // might let the vehicle avoid a conflict, so only nodes that arrive at
+  // exactly the same time are compared.
+  DominanceMap::Key dominance_key(const NodePtr& node) const
+  {
+    const Duration::rep time = _context.validator ?
+      node->route_from_parent.trajectory.back().time()
+      .time_since_epoch().count() : 0;
+
+    return DominanceMap::key(*node->waypoint, node->orientation, time);
+  }
+
+  static DominanceMap::Entry dominance_entry(const NodePtr& node)
+  {
+    return DominanceMap::Entry{
+      node->orientation,
+      node->route_from_parent.trajectory.back().time(),
+      node->current_cost
+    };
+  }
+
+  // Check whether the same state has already been expanded at an earlier time
+  // or a lower cost, without being later or more expensive in the other
+  bool is_dominated(const NodePtr& node) const
+  {
+    if (!_context.dominance || !node->waypoint)
+      return false;
+
+    return _context.dominance->dominated(
+      dominance_key(node), dominance_entry(node));
+  }
+
+  void push_if_not_dominated(const NodePtr& node, SearchQueue& queue)
+  {
+    if (is_dominated(node))
+    {
+      ++_context.dominance->pruned;
+      return;
+    }
+
+    queue.push(node);
+  }
+
   struct LaneExpansionNode
   {
     std::size_t lane;
@@ -1342,10 +1964,10 @@ struct DifferentialDriveExpander
         if (!is_valid(route, initial_parent))
           continue;
 
-        auto parent_to_event = std::make_shared<Node>(
+        auto parent_to_event = make_node(
           Node{
             _context.heuristic.estimate_remaining_cost(
-              _context, exit_waypoint_index),
+              _context, exit_waypoint_index, orientation),
             compute_current_cost(initial_parent, trajectory),
             exit_waypoint_index,
             orientation,
@@ -1483,7 +2105,7 @@ struct DifferentialDriveExpander
     if (node)
     {
 //      std::cout << "Expand holding" << std::endl;
-      queue.push(node);
+      push_if_not_dominated(node, queue);
     }
   }
 
@@ -1497,6 +2119,19 @@ struct DifferentialDriveExpander
 
   void expand(const NodePtr& parent_node, SearchQueue& queue)
   {
+    if (is_dominated(parent_node))
+    {
+      // The same state was expanded after this node was queued
+      ++_context.dominance->pruned;
+      return;
+    }
+
+    if (_context.dominance && parent_node->waypoint)
+    {
+      _context.dominance->insert(
+        dominance_key(parent_node), dominance_entry(parent_node));
+    }
+
     const bool has_waypoint = parent_node->waypoint.has_value();
     if (has_waypoint)
     {
@@ -1564,6 +2199,93 @@ private:
 
 //==============================================================================
 namespace {
+// The serialized heuristics are a binary blob with this layout, using the
+// native byte order:
+//
+//   char[8]   HeuristicsMagic
+//   uint64_t  HeuristicsFormatVersion
+//   uint64_t  fingerprint of the inputs that the costs depend on
+//   uint64_t  number of waypoints in the graph
+//   uint64_t  number of tables
+//   for each table:
+//     uint64_t  goal waypoint
+//     double    cost from each waypoint to the goal
+const char HeuristicsMagic[8] = {'R', 'M', 'F', 'H', 'E', 'U', 'R', '1'};
+
+// This must be incremented whenever the layout above or the way that the
+// costs are computed changes. Version 1 had no version or fingerprint fields.
+const uint64_t HeuristicsFormatVersion = 2;
+
+//==============================================================================
+// A 64-bit FNV-1a hash of the raw bytes of the values that are added to it
+class Fingerprint
+{
+public:
+
+  template<typename T>
+  Fingerprint& add(const T value)
+  {
+    static_assert(std::is_arithmetic<T>::value,
+      "Only arithmetic values can be fingerprinted");
+
+    const auto* const bytes = reinterpret_cast<const unsigned char*>(&value);
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+    {
+      _hash ^= bytes[i];
+      _hash *= 1099511628211ull;
+    }
+
+    return *this;
+  }
+
+  uint64_t value() const
+  {
+    return _hash;
+  }
+
+private:
+  uint64_t _hash = 14695981039346656037ull;
+};
+
+//==============================================================================
+// Fingerprint everything that Heuristic::compute_costs() reads: the waypoint
+// locations, the lane endpoints and event durations, and the linear traits
+// that the estimates are interpolated with.
+uint64_t heuristics_fingerprint(
+  const agv::Graph::Implementation& graph,
+  const agv::VehicleTraits& traits)
+{
+  Fingerprint fingerprint;
+  fingerprint.add(static_cast<uint64_t>(graph.waypoints.size()));
+  for (const auto& waypoint : graph.waypoints)
+  {
+    const Eigen::Vector2d& p = waypoint.get_location();
+    fingerprint.add(p[0]).add(p[1]);
+  }
+
+  const auto add_event = [&](const agv::Graph::Lane::Event* event)
+    {
+      fingerprint.add(static_cast<uint8_t>(event != nullptr));
+      if (event)
+        fingerprint.add(event->duration().count());
+    };
+
+  fingerprint.add(static_cast<uint64_t>(graph.lanes.size()));
+  for (const auto& lane : graph.lanes)
+  {
+    fingerprint.add(static_cast<uint64_t>(lane.entry().waypoint_index()));
+    fingerprint.add(static_cast<uint64_t>(lane.exit().waypoint_index()));
+    add_event(lane.entry().event());
+    add_event(lane.exit().event());
+  }
+
+  fingerprint.add(traits.linear().get_nominal_velocity());
+  fingerprint.add(traits.linear().get_nominal_acceleration());
+
+  return fingerprint.value();
+}
+
+//==============================================================================
 class DifferentialDriveCache : public Cache
 {
 public:
@@ -1578,33 +2300,39 @@ public:
     _traits(_config.vehicle_traits()),
     _profile(_traits.profile()),
     _interpolate(agv::Interpolate::Options::Implementation::get(
-        _config.interpolation()))
+        _config.interpolation())),
+    _heuristics(_graph.waypoints.size())
   {
     // Do nothing
   }
 
-  CachePtr clone() const final
-  {
-    return std::make_shared<DifferentialDriveCache>(*this);
-  }
-
-  void update(const Cache& newer_cache) override final
-  {
-    const auto& newer = static_cast<const DifferentialDriveCache&>(newer_cache);
-
-    for (const auto& h : newer._heuristics)
-    {
-      auto& heuristic = _heuristics.insert(
-        std::make_pair(h.first, Heuristic{})).first->second;
-
-      heuristic.update(h.second);
-    }
-  }
+  // The cache refers to its own configuration, so it must not be copied
+  DifferentialDriveCache(const DifferentialDriveCache&) = delete;
+  DifferentialDriveCache& operator=(const DifferentialDriveCache&) = delete;
 
   class InternalState : public State::Internal
   {
   public:
     DifferentialDriveExpander::SearchQueue queue;
+    DifferentialDriveExpander::DominanceMap dominance;
+
+    // Every node of this search is allocated from the arena, and they are all
+    // released together when the last state that refers to them is gone.
+    DifferentialDriveExpander::ArenaPtr arena =
+      std::make_shared<DifferentialDriveExpander::Arena>();
+
+    InternalState() = default;
+
+    // A copy of a state may keep searching on its own, so it gets a new arena
+    // for its new nodes. That arena keeps the original arena alive, because
+    // the queued nodes still live there.
+    InternalState(const InternalState& other)
+    : queue(other.queue),
+      dominance(other.dominance),
+      arena(std::make_shared<DifferentialDriveExpander::Arena>(other.arena))
+    {
+      // Do nothing
+    }
 
     rmf_utils::optional<double> cost_estimate() const final
     {
@@ -1614,6 +2342,11 @@ public:
       const auto& top = queue.top();
       return top->current_cost + top->remaining_cost_estimate;
     }
+
+    std::size_t pruned_node_count() const final
+    {
+      return dominance.pruned;
+    }
   };
 
   State initiate(
@@ -1631,14 +2364,16 @@ public:
       rmf_utils::make_derived_impl<State::Internal, InternalState>()
     };
 
+    auto& internal = *static_cast<InternalState*>(state.internal.get());
     auto context = make_context(
       state.conditions.goal,
       state.conditions.options,
       state.issues.blocked_nodes,
-      false);
+      false,
+      internal.arena);
 
     DifferentialDriveExpander expander(context);
-    auto& queue = static_cast<InternalState*>(state.internal.get())->queue;
+    auto& queue = internal.queue;
 
     expander.make_initial_nodes(
       DifferentialDriveExpander::InitialNodeArgs{
@@ -1653,14 +2388,17 @@ public:
     if (state.conditions.starts.empty())
       return rmf_utils::nullopt;
 
+    auto& internal = *static_cast<InternalState*>(state.internal.get());
     auto context = make_context(
       state.conditions.goal,
       state.conditions.options,
       state.issues.blocked_nodes,
-      false);
+      false,
+      internal.arena,
+      &internal.dominance);
 
     DifferentialDriveExpander expander(context);
-    auto& queue = static_cast<InternalState*>(state.internal.get())->queue;
+    auto& queue = internal.queue;
     const bool* interrupt_flag = state.conditions.options.interrupt_flag();
 
     const NodePtr solution =
@@ -1708,12 +2446,17 @@ public:
 //      >;
 
 //    RolloutQueue rollout_queue;
+    // The keys of the blocked nodes keep the arenas of their nodes alive, so
+    // we can safely refer to the nodes by raw pointer while we roll out.
+    std::unordered_set<const void*> blocked_nodes;
+    for (const auto& void_node : nodes)
+      blocked_nodes.insert(void_node.first.get());
+
     std::vector<RolloutEntry> rollout_queue;
     for (const auto& void_node : nodes)
     {
       bool skip = false;
-      const auto original_node =
-        std::static_pointer_cast<Node>(void_node.first);
+      const NodePtr original_node = static_cast<Node*>(void_node.first.get());
 
       const auto original_t = void_node.second;
 
@@ -1728,7 +2471,7 @@ public:
       auto ancestor = original_node->parent;
       while (ancestor)
       {
-        if (nodes.count(ancestor) > 0)
+        if (blocked_nodes.count(ancestor) > 0)
         {
           // TODO(MXG): Consider if we should account for the time difference
           // between these conflicts so that we get a broader rollout.
@@ -1765,7 +2508,9 @@ public:
     std::vector<schedule::Itinerary> alternatives;
 
     Issues::BlockerMap temp_blocked_nodes;
-    auto context = make_context(goal, options, temp_blocked_nodes, true);
+    auto context = make_context(
+      goal, options, temp_blocked_nodes, true,
+      std::make_shared<DifferentialDriveExpander::Arena>());
     DifferentialDriveExpander expander(context);
 
     const bool* interrupt_flag = options.interrupt_flag();
@@ -1831,6 +2576,112 @@ public:
     return _config;
   }
 
+  void precompute_heuristics() final
+  {
+    const std::size_t N = _graph.waypoints.size();
+    for (std::size_t goal = 0; goal < N; ++goal)
+    {
+      Heuristic& h = _heuristics[goal];
+      if (!h.costs())
+        h.set_costs(Heuristic::compute_costs(_graph, _traits, goal));
+    }
+  }
+
+  void save_heuristics(std::ostream& output) const final
+  {
+    const uint64_t N = _graph.waypoints.size();
+
+    // Take a snapshot first, because other threads may publish more tables
+    // while we are writing.
+    std::vector<std::pair<uint64_t, Heuristic::TablePtr>> tables;
+    for (std::size_t goal = 0; goal < _heuristics.size(); ++goal)
+    {
+      if (auto costs = _heuristics[goal].costs())
+        tables.emplace_back(goal, std::move(costs));
+    }
+
+    output.write(HeuristicsMagic, 8);
+    write_value(output, HeuristicsFormatVersion);
+    write_value(output, heuristics_fingerprint(_graph, _traits));
+    write_value(output, N);
+    write_value(output, static_cast<uint64_t>(tables.size()));
+    for (const auto& table : tables)
+    {
+      write_value(output, table.first);
+      output.write(
+        reinterpret_cast<const char*>(table.second->data()),
+        static_cast<std::streamsize>(N * sizeof(double)));
+    }
+  }
+
+  void load_heuristics(std::istream& input) final
+  {
+    char magic[8];
+    input.read(magic, 8);
+    if (!input || std::memcmp(magic, HeuristicsMagic, 8) != 0)
+    {
+      throw std::invalid_argument(
+        "[rmf_traffic::agv::Planner::load_heuristics] The input does not "
+        "contain serialized planner heuristics");
+    }
+
+    const uint64_t version = read_value<uint64_t>(input);
+    if (version != HeuristicsFormatVersion)
+    {
+      // *INDENT-OFF*
+      throw std::invalid_argument(
+        "[rmf_traffic::agv::Planner::load_heuristics] The heuristics use "
+        "format version [" + std::to_string(version) + "], but only version ["
+        + std::to_string(HeuristicsFormatVersion) + "] is supported");
+      // *INDENT-ON*
+    }
+
+    const uint64_t fingerprint = read_value<uint64_t>(input);
+    if (fingerprint != heuristics_fingerprint(_graph, _traits))
+    {
+      throw std::invalid_argument(
+        "[rmf_traffic::agv::Planner::load_heuristics] The heuristics were "
+        "computed for a different graph or different vehicle traits");
+    }
+
+    const uint64_t N = _graph.waypoints.size();
+    const uint64_t input_N = read_value<uint64_t>(input);
+    if (input_N != N)
+    {
+      // *INDENT-OFF*
+      throw std::invalid_argument(
+        "[rmf_traffic::agv::Planner::load_heuristics] The heuristics were "
+        "computed for a graph with [" + std::to_string(input_N) + "] "
+        "waypoints, but this planner's graph has [" + std::to_string(N)
+        + "] waypoints");
+      // *INDENT-ON*
+    }
+
+    const uint64_t num_tables = read_value<uint64_t>(input);
+    std::vector<std::pair<std::size_t, std::vector<double>>> tables;
+    for (uint64_t i = 0; i < num_tables; ++i)
+    {
+      const uint64_t goal = read_value<uint64_t>(input);
+      std::vector<double> costs(N);
+      input.read(
+        reinterpret_cast<char*>(costs.data()),
+        static_cast<std::streamsize>(N * sizeof(double)));
+
+      if (!input || goal >= N)
+      {
+        throw std::invalid_argument(
+          "[rmf_traffic::agv::Planner::load_heuristics] The serialized "
+          "heuristics are corrupted or truncated");
+      }
+
+      tables.emplace_back(goal, std::move(costs));
+    }
+
+    // Only modify the cache once we know that the whole input is valid
+    for (auto& table : tables)
+      _heuristics[table.first].set_costs(std::move(table.second));
+  }
+
   class Debugger : public Cache::Debugger
   {
   public:
@@ -1911,6 +2762,8 @@ public:
     std::vector<agv::Planner::Debug::ConstNodePtr> expanded_nodes_;
     std::vector<agv::Planner::Debug::ConstNodePtr> terminal_nodes_;
     Issues::BlockerMap blocked_nodes_;
+    DifferentialDriveExpander::ArenaPtr arena_ =
+      std::make_shared<DifferentialDriveExpander::Arena>();
 
     std::vector<agv::Planner::Start> starts_;
     agv::Planner::Goal goal_;
@@ -1948,7 +2801,8 @@ public:
       std::move(options));
 
     auto context = make_context(
-      debugger->goal_, debugger->options_, debugger->blocked_nodes_, false);
+      debugger->goal_, debugger->options_, debugger->blocked_nodes_, false,
+      debugger->arena_);
 
     DifferentialDriveExpander expander(context);
 
@@ -1974,7 +2828,8 @@ public:
     debugger.expanded_nodes_.push_back(debugger.convert(top));
 
     auto context = make_context(
-      debugger.goal_, debugger.options_, debugger.blocked_nodes_, false);
+      debugger.goal_, debugger.options_, debugger.blocked_nodes_, false,
+      debugger.arena_);
 
     DifferentialDriveExpander expander(context);
     if (expander.is_finished(top))
@@ -1998,6 +2853,27 @@ public:
 
 private:
 
+  template<typename T>
+  static void write_value(std::ostream& output, const T value)
+  {
+    output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template<typename T>
+  static T read_value(std::istream& input)
+  {
+    T value;
+    input.read(reinterpret_cast<char*>(&value), sizeof(T));
+    if (!input)
+    {
+      throw std::invalid_argument(
+        "[rmf_traffic::agv::Planner::load_heuristics] The serialized "
+        "heuristics are corrupted or truncated");
+    }
+
+    return value;
+  }
+
   Plan make_plan(
     const std::vector<agv::Planner::Start>& starts,
     const NodePtr& solution,
@@ -2019,15 +2895,26 @@ private:
     const agv::Planner::Goal& goal,
     const agv::Planner::Options& options,
     Issues::BlockerMap& blocked_nodes,
-    const bool simple_lane_expansion)
+    const bool simple_lane_expansion,
+    DifferentialDriveExpander::ArenaPtr arena,
+    DifferentialDriveExpander::DominanceMap* dominance = nullptr)
   {
     const std::size_t goal_waypoint = goal.waypoint();
+    if (goal_waypoint >= _heuristics.size())
+    {
+      // *INDENT-OFF*
+      throw std::invalid_argument(
+        "[rmf_traffic::agv::Planner] Goal waypoint index ["
+        + std::to_string(goal_waypoint) + "] is out of range for a graph "
+        "with [" + std::to_string(_heuristics.size()) + "] waypoints");
+      // *INDENT-ON*
+    }
+
     rmf_utils::optional<double> goal_orientation;
     if (goal.orientation())
       goal_orientation = *goal.orientation();
 
-    Heuristic& h = _heuristics.insert(
-      std::make_pair(goal_waypoint, Heuristic{})).first->second;
+    Heuristic& h = _heuristics[goal_waypoint];
     const bool* const interrupt_flag = options.interrupt_flag();
 
     return DifferentialDriveExpander::Context{
@@ -2042,7 +2929,9 @@ private:
       interrupt_flag,
       h,
       blocked_nodes,
-      simple_lane_expansion
+      simple_lane_expansion,
+      std::move(arena),
+      dominance
     };
   }
 
@@ -2053,10 +2942,10 @@ private:
   const Profile& _profile;
   const agv::Interpolate::Options::Implementation& _interpolate;
 
-  // This maps from a goal waypoint to the cached Heuristic object that tries to
-  // plan to that goal waypoint.
-  using HeuristicDatabase = std::unordered_map<std::size_t, Heuristic>;
-  HeuristicDatabase _heuristics;
+  // The cached Heuristic for each goal waypoint. There is exactly one entry per
+  // waypoint of the graph, so planning threads can look up their goal without
+  // any locking, and every thread shares the same tables.
+  std::vector<Heuristic> _heuristics;
 };
 } // anonymous namespace
 
@@ -2065,8 +2954,14 @@ CacheManager make_cache(agv::Planner::Configuration config)
 {
   if (config.vehicle_traits().get_differential())
   {
-    return CacheManager(std::make_shared<DifferentialDriveCache>(
-          std::move(config)));
+    const bool precompute = config.precompute_heuristics();
+    CacheManager manager(std::make_shared<DifferentialDriveCache>(
+        std::move(config)));
+
+    if (precompute)
+      manager.precompute_heuristics();
+
+    return manager;
   }
 
   // *INDENT-OFF*
@@ -21,8 +21,8 @@
 #include <rmf_traffic/agv/Planner.hpp>
 #include <rmf_traffic/agv/debug/Planner.hpp>
 
+#include <iosfwd>
 #include <memory>
-#include <mutex>
 
 namespace rmf_traffic {
 namespace internal {
@@ -61,6 +61,8 @@ struct State
 
     virtual rmf_utils::optional<double> cost_estimate() const = 0;
 
+    virtual std::size_t pruned_node_count() const = 0;
+
     virtual ~Internal() = default;
   };
 
@@ -80,20 +82,8 @@ class Cache
 {
 public:
 
-  // TODO(MXG): Consider using libguarded instead of using mutexes manually
-  std::mutex mutex;
-
-  // We need to explicitly define these because the std::mutex does not have
-  // a copy constructor
-  Cache() = default;
-  Cache(const Cache&);
-  Cache(Cache&&);
-  Cache& operator=(const Cache&);
-  Cache& operator=(Cache&&);
-
-  virtual CachePtr clone() const = 0;
-
-  virtual void update(const Cache& other) = 0;
+  // A single Cache instance is shared by every planning thread of a Planner,
+  // so implementations must make these functions safe to call concurrently.
 
   virtual State initiate(
     const std::vector<agv::Planner::Start>& starts,
@@ -110,6 +100,15 @@ public:
 
   virtual const agv::Planner::Configuration& get_configuration() const = 0;
 
+  /// Fill in the heuristic table for every waypoint of the graph as a goal.
+  virtual void precompute_heuristics() = 0;
+
+  /// Write every heuristic table that has been computed so far.
+  virtual void save_heuristics(std::ostream& output) const = 0;
+
+  /// Read heuristic tables that were written by save_heuristics().
+  virtual void load_heuristics(std::istream& input) = 0;
+
   class Debugger
   {
   public:
@@ -140,7 +139,7 @@ class CacheHandle
 {
 public:
 
-  CacheHandle(CachePtr original);
+  CacheHandle(CachePtr cache);
 
   // Copying this class does not make sense
   CacheHandle(const CacheHandle&) = delete;
@@ -156,13 +155,9 @@ public:
 
   const Cache& operator*() const&;
 
-  ~CacheHandle();
-
 private:
 
-  CachePtr _copy;
-
-  CachePtr _original;
+  CachePtr _cache;
 
 };
 
@@ -177,6 +172,12 @@ public:
 
   const agv::Planner::Configuration& get_configuration() const;
 
+  void precompute_heuristics();
+
+  void save_heuristics(std::ostream& output) const;
+
+  void load_heuristics(std::istream& input);
+
 private:
   CachePtr _cache;
 
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_traffic/schedule/BucketPolicy.hpp>
+
+#include <stdexcept>
+#include <string>
+
+namespace rmf_traffic {
+namespace schedule {
+
+namespace {
+//==============================================================================
+void check_positive(Duration duration, const char* name)
+{
+  if (duration > Duration(0))
+    return;
+
+  // *INDENT-OFF*
+  throw std::invalid_argument(
+    std::string("[rmf_traffic::schedule::BucketPolicy] The ") + name
+    + " must be positive, but a value of "
+    + std::to_string(time::to_seconds(duration)) + "s was given");
+  // *INDENT-ON*
+}
+
+//==============================================================================
+void check_bucket_limits(Duration min_duration, Duration max_duration)
+{
+  if (min_duration <= max_duration)
+    return;
+
+  // *INDENT-OFF*
+  throw std::invalid_argument(
+    "[rmf_traffic::schedule::BucketPolicy] The min_bucket_duration ("
+    + std::to_string(time::to_seconds(min_duration))
+    + "s) must not exceed the max_bucket_duration ("
+    + std::to_string(time::to_seconds(max_duration)) + "s)");
+  // *INDENT-ON*
+}
+
+//==============================================================================
+void check_thresholds(std::size_t split, std::size_t merge)
+{
+  if (merge < split)
+    return;
+
+  // *INDENT-OFF*
+  throw std::invalid_argument(
+    "[rmf_traffic::schedule::BucketPolicy] The merge_threshold ("
+    + std::to_string(merge) + ") must be smaller than the split_threshold ("
+    + std::to_string(split) + "), or else buckets would be split and merged "
+    "back and forth forever");
+  // *INDENT-ON*
+}
+} // anonymous namespace
+
+//==============================================================================
+class BucketPolicy::Implementation
+{
+public:
+
+  Duration bucket_duration;
+  bool adaptive;
+  std::size_t split_threshold = 256;
+  std::size_t merge_threshold = 16;
+  Duration min_bucket_duration = std::chrono::seconds(5);
+  Duration max_bucket_duration = std::chrono::minutes(10);
+
+};
+
+//==============================================================================
+BucketPolicy::BucketPolicy(Duration bucket_duration, bool adaptive)
+: _pimpl(rmf_utils::make_impl<Implementation>(
+      Implementation{bucket_duration, adaptive}))
+{
+  check_positive(bucket_duration, "bucket_duration");
+}
+
+//==============================================================================
+BucketPolicy& BucketPolicy::bucket_duration(Duration duration)
+{
+  check_positive(duration, "bucket_duration");
+  _pimpl->bucket_duration = duration;
+  return *this;
+}
+
+//==============================================================================
+Duration BucketPolicy::bucket_duration() const
+{
+  return _pimpl->bucket_duration;
+}
+
+//==============================================================================
+BucketPolicy& BucketPolicy::adaptive(bool on)
+{
+  _pimpl->adaptive = on;
+  return *this;
+}
+
+//==============================================================================
+bool BucketPolicy::adaptive() const
+{
+  return _pimpl->adaptive;
+}
+
+//==============================================================================
+BucketPolicy& BucketPolicy::split_threshold(std::size_t count)
+{
+  check_thresholds(count, _pimpl->merge_threshold);
+  _pimpl->split_threshold = count;
+  return *this;
+}
+
+//==============================================================================
+std::size_t BucketPolicy::split_threshold() const
+{
+  return _pimpl->split_threshold;
+}
+
+//==============================================================================
+BucketPolicy& BucketPolicy::merge_threshold(std::size_t count)
+{
+  check_thresholds(_pimpl->split_threshold, count);
+  _pimpl->merge_threshold = count;
+  return *this;
+}
+
+//==============================================================================
+std::size_t BucketPolicy::merge_threshold() const
+{
+  return _pimpl->merge_threshold;
+}
+
+//==============================================================================
+BucketPolicy& BucketPolicy::min_bucket_duration(Duration duration)
+{
+  check_positive(duration, "min_bucket_duration");
+  check_bucket_limits(duration, _pimpl->max_bucket_duration);
+  _pimpl->min_bucket_duration = duration;
+  return *this;
+}
+
+//==============================================================================
+Duration BucketPolicy::min_bucket_duration() const
+{
+  return _pimpl->min_bucket_duration;
+}
+
+//==============================================================================
+BucketPolicy& BucketPolicy::max_bucket_duration(Duration duration)
+{
+  check_positive(duration, "max_bucket_duration");
+  check_bucket_limits(_pimpl->min_bucket_duration, duration);
+  _pimpl->max_bucket_duration = duration;
+  return *this;
+}
+
+//==============================================================================
+Duration BucketPolicy::max_bucket_duration() const
+{
+  return _pimpl->max_bucket_duration;
+}
+
+} // namespace schedule
+} // namespace rmf_traffic
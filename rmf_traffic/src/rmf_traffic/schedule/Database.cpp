@@ -29,6 +29,7 @@
 #include <rmf_utils/Modular.hpp>
 
 #include <algorithm>
+#include <deque>
 #include <list>
 
 namespace rmf_traffic {
@@ -168,10 +169,66 @@ public:
 
   rmf_utils::optional<CullInfo> last_cull;
 
+  /// A record of which routes were changed by a version of the schedule.
+  struct ChangeLogRecord
+  {
+    Version version;
+    std::vector<std::pair<ParticipantId, RouteId>> routes;
+  };
+
+  /// The change log lets us assemble a patch for a mirror that is only a few
+  /// versions behind without searching through the whole timeline. Records
+  /// older than the horizon get dropped, and change_log_begin tells us which
+  /// version the log is complete after.
+  std::deque<ChangeLogRecord> change_log;
+  std::size_t change_log_horizon = 1000;
+  Version change_log_begin = 0;
+
+  /// How many threads may share the work of a large region query
+  std::size_t query_workers = 1;
+
   /// The current time is used to know when participants can be culled after
   /// getting unregistered
   rmf_traffic::Time current_time = rmf_traffic::Time(rmf_traffic::Duration(0));
 
+  Implementation(const BucketPolicy& bucket_policy)
+  : timeline(bucket_policy)
+  {
+    // Do nothing
+  }
+
+  /// Note that a route has been changed by the current schedule version.
+  void log_change(ParticipantId participant, RouteId route_id)
+  {
+    if (change_log.empty() || change_log.back().version != schedule_version)
+    {
+      change_log.push_back({schedule_version, {}});
+      trim_change_log();
+    }
+
+    if (!change_log.empty())
+      change_log.back().routes.emplace_back(participant, route_id);
+  }
+
+  /// Drop any records that have fallen behind the horizon of the change log.
+  void trim_change_log()
+  {
+    while (!change_log.empty()
+      && schedule_version - change_log.front().version >= change_log_horizon)
+    {
+      change_log_begin = change_log.front().version;
+      change_log.pop_front();
+    }
+  }
+
+  /// Check whether the change log has a record of every route change that
+  /// happened after the given version.
+  bool change_log_covers(Version after) const
+  {
+    return !rmf_utils::modular(after).less_than(change_log_begin)
+      && !rmf_utils::modular(schedule_version).less_than(after);
+  }
+
   /// This function verifies that the route IDs specified in the input are not
   /// already being used. If that ever happens, it is indicative of a bug or a
   /// malformed input into the database.
@@ -247,6 +304,7 @@ public:
         });
 
       entry_storage.timeline_handle = timeline.insert(entry_storage.entry);
+      log_change(participant, route_id);
     }
   }
 
@@ -297,6 +355,7 @@ public:
         entry_storage.entry;
 
       entry_storage.timeline_handle = timeline.insert(entry_storage.entry);
+      log_change(participant, id);
     }
   }
 
@@ -332,6 +391,7 @@ public:
         entry_storage.entry;
 
       entry_storage.timeline_handle = timeline.insert(entry_storage.entry);
+      log_change(participant, id);
     }
 
     // TODO(MXG): Consider erasing the routes from the active_routes field of
@@ -733,6 +793,30 @@ struct ParticipantChanges
   std::vector<RouteId> erasures;
 };
 
+//==============================================================================
+void merge_changes(
+  std::unordered_map<ParticipantId, ParticipantChanges>& into,
+  std::unordered_map<ParticipantId, ParticipantChanges>&& from)
+{
+  for (auto& p : from)
+  {
+    ParticipantChanges& target = into[p.first];
+    ParticipantChanges& source = p.second;
+
+    target.additions.insert(
+      target.additions.end(),
+      std::make_move_iterator(source.additions.begin()),
+      std::make_move_iterator(source.additions.end()));
+
+    target.delays.insert(source.delays.begin(), source.delays.end());
+
+    target.erasures.insert(
+      target.erasures.end(),
+      source.erasures.begin(),
+      source.erasures.end());
+  }
+}
+
 //==============================================================================
 class PatchRelevanceInspector
   : public TimelineInspector<Database::Implementation::RouteEntry>
@@ -749,6 +833,16 @@ public:
 
   std::unordered_map<ParticipantId, ParticipantChanges> changes;
 
+  PatchRelevanceInspector fork() const
+  {
+    return PatchRelevanceInspector(_after);
+  }
+
+  void merge(PatchRelevanceInspector&& other)
+  {
+    merge_changes(changes, std::move(other.changes));
+  }
+
   const RouteEntry* get_last_known_ancestor(const RouteEntry* from) const
   {
     assert(from);
@@ -863,6 +957,16 @@ public:
 
   std::unordered_map<ParticipantId, ParticipantChanges> changes;
 
+  FirstPatchRelevanceInspector fork() const
+  {
+    return FirstPatchRelevanceInspector();
+  }
+
+  void merge(FirstPatchRelevanceInspector&& other)
+  {
+    merge_changes(changes, std::move(other.changes));
+  }
+
   void inspect(
     const RouteEntry* entry,
     const std::function<bool(const RouteEntry&)>& relevant) final
@@ -890,6 +994,19 @@ public:
 
   std::vector<Storage> routes;
 
+  ViewRelevanceInspector fork() const
+  {
+    return ViewRelevanceInspector();
+  }
+
+  void merge(ViewRelevanceInspector&& other)
+  {
+    routes.insert(
+      routes.end(),
+      std::make_move_iterator(other.routes.begin()),
+      std::make_move_iterator(other.routes.end()));
+  }
+
   void inspect(
     const RouteEntry* entry,
     const std::function<bool(const RouteEntry&)>& relevant) final
@@ -908,6 +1025,44 @@ public:
   }
 };
 
+//==============================================================================
+class VisitRelevanceInspector
+  : public TimelineInspector<Database::Implementation::RouteEntry>
+{
+public:
+
+  using RouteEntry = Database::Implementation::RouteEntry;
+
+  VisitRelevanceInspector(const Viewer::Visitor& visitor)
+  : _visitor(visitor)
+  {
+    // Do nothing
+  }
+
+  void inspect(
+    const RouteEntry* entry,
+    const std::function<bool(const RouteEntry&)>& relevant) final
+  {
+    entry = get_most_recent(entry);
+    if (entry->route && relevant(*entry))
+    {
+      const bool keep_going = _visitor(
+        Viewer::View::Element{
+          entry->participant,
+          entry->route_id,
+          *entry->route,
+          *entry->description
+        });
+
+      if (!keep_going)
+        finish();
+    }
+  }
+
+private:
+  const Viewer::Visitor& _visitor;
+};
+
 //==============================================================================
 class ViewerAfterRelevanceInspector
   : public TimelineInspector<Database::Implementation::RouteEntry>
@@ -927,6 +1082,19 @@ public:
     // Do nothing
   }
 
+  ViewerAfterRelevanceInspector fork() const
+  {
+    return ViewerAfterRelevanceInspector(after);
+  }
+
+  void merge(ViewerAfterRelevanceInspector&& other)
+  {
+    routes.insert(
+      routes.end(),
+      std::make_move_iterator(other.routes.begin()),
+      std::make_move_iterator(other.routes.end()));
+  }
+
   void inspect(
     const RouteEntry* entry,
     const std::function<bool(const RouteEntry&)>& relevant) final
@@ -1005,10 +1173,49 @@ Viewer::View Database::query(
   const Query::Participants& participants) const
 {
   ViewRelevanceInspector inspector;
-  _pimpl->timeline.inspect(spacetime, participants, inspector);
+  _pimpl->timeline.inspect(
+    spacetime, participants, inspector, _pimpl->query_workers);
   return Viewer::View::Implementation::make_view(std::move(inspector.routes));
 }
 
+//==============================================================================
+Viewer::View Database::query(
+  const std::string& map,
+  const Time lower_time_bound,
+  const Time upper_time_bound,
+  const Query::Participants& participants) const
+{
+  ViewRelevanceInspector inspector;
+  _pimpl->timeline.inspect_timespan(
+    map, &lower_time_bound, &upper_time_bound, participants, inspector);
+  return Viewer::View::Implementation::make_view(std::move(inspector.routes));
+}
+
+//==============================================================================
+bool Database::visit(
+  const Query::Spacetime& spacetime,
+  const Query::Participants& participants,
+  const Visitor& visitor) const
+{
+  VisitRelevanceInspector inspector(visitor);
+  _pimpl->timeline.inspect(spacetime, participants, inspector);
+  return !inspector.finished();
+}
+
+//==============================================================================
+bool Database::visit(
+  const std::string& map,
+  const Time lower_time_bound,
+  const Time upper_time_bound,
+  const Query::Participants& participants,
+  const Visitor& visitor) const
+{
+  VisitRelevanceInspector inspector(visitor);
+  _pimpl->timeline.inspect_timespan(
+    map, &lower_time_bound, &upper_time_bound, participants, inspector);
+  return !inspector.finished();
+}
+
 //==============================================================================
 const std::unordered_set<ParticipantId>& Database::participant_ids() const
 {
@@ -1054,7 +1261,10 @@ Version Database::latest_version() const
 std::shared_ptr<const Snapshot> Database::snapshot() const
 {
   using SnapshotType =
-    SnapshotImplementation<Implementation::RouteEntry, ViewRelevanceInspector>;
+    SnapshotImplementation<Implementation::RouteEntry,
+      ViewRelevanceInspector,
+      VisitRelevanceInspector
+    >;
 
   return std::make_shared<SnapshotType>(
     _pimpl->timeline.snapshot(),
@@ -1064,8 +1274,8 @@ std::shared_ptr<const Snapshot> Database::snapshot() const
 }
 
 //==============================================================================
-Database::Database()
-: _pimpl(rmf_utils::make_unique_impl<Implementation>())
+Database::Database(const BucketPolicy& bucket_policy)
+: _pimpl(rmf_utils::make_unique_impl<Implementation>(bucket_policy))
 {
   // Do nothing
 }
@@ -1082,11 +1292,51 @@ auto Database::changes(
   rmf_utils::optional<Version> after) const -> Patch
 {
   std::unordered_map<ParticipantId, ParticipantChanges> changes;
-  if (after)
+  if (after && _pimpl->change_log_covers(*after))
+  {
+    // The change log knows every route that changed since the mirror's last
+    // update, so we only need to inspect those routes.
+    using RouteEntry = Implementation::RouteEntry;
+    std::vector<const RouteEntry*> candidates;
+    std::unordered_map<ParticipantId, std::unordered_set<RouteId>> checked;
+    for (const auto& record : _pimpl->change_log)
+    {
+      if (!rmf_utils::modular(*after).less_than(record.version))
+        continue;
+
+      for (const auto& route : record.routes)
+      {
+        if (!checked[route.first].insert(route.second).second)
+          continue;
+
+        // Routes that have since been culled or whose participant has been
+        // unregistered are no longer in the timeline, so they are skipped,
+        // just like they would be by a full search.
+        const auto p_it = _pimpl->states.find(route.first);
+        if (p_it == _pimpl->states.end())
+          continue;
+
+        const auto& storage = p_it->second.storage;
+        const auto r_it = storage.find(route.second);
+        if (r_it == storage.end())
+          continue;
+
+        candidates.push_back(r_it->second.entry.get());
+      }
+    }
+
+    PatchRelevanceInspector inspector(*after);
+    _pimpl->timeline.inspect_candidates(
+      parameters.spacetime(), parameters.participants(), candidates, inspector);
+
+    changes = inspector.changes;
+  }
+  else if (after)
   {
     PatchRelevanceInspector inspector(*after);
     _pimpl->timeline.inspect(
-      parameters.spacetime(), parameters.participants(), inspector);
+      parameters.spacetime(), parameters.participants(), inspector,
+      _pimpl->query_workers);
 
     changes = inspector.changes;
   }
@@ -1094,7 +1344,8 @@ auto Database::changes(
   {
     FirstPatchRelevanceInspector inspector;
     _pimpl->timeline.inspect(
-      parameters.spacetime(), parameters.participants(), inspector);
+      parameters.spacetime(), parameters.participants(), inspector,
+      _pimpl->query_workers);
 
     changes = inspector.changes;
   }
@@ -1173,7 +1424,8 @@ Viewer::View Database::query(const Query& parameters, const Version after) const
 {
   ViewerAfterRelevanceInspector inspector{after};
   _pimpl->timeline.inspect(
-    parameters.spacetime(), parameters.participants(), inspector);
+    parameters.spacetime(), parameters.participants(), inspector,
+    _pimpl->query_workers);
 
   return Viewer::View::Implementation::make_view(std::move(inspector.routes));
 }
@@ -1237,6 +1489,31 @@ void Database::set_current_time(Time time)
   _pimpl->current_time = time;
 }
 
+//==============================================================================
+void Database::set_change_log_horizon(std::size_t versions)
+{
+  _pimpl->change_log_horizon = versions;
+  _pimpl->trim_change_log();
+}
+
+//==============================================================================
+std::size_t Database::get_change_log_horizon() const
+{
+  return _pimpl->change_log_horizon;
+}
+
+//==============================================================================
+void Database::set_query_workers(std::size_t workers)
+{
+  _pimpl->query_workers = std::max<std::size_t>(1, workers);
+}
+
+//==============================================================================
+std::size_t Database::get_query_workers() const
+{
+  return _pimpl->query_workers;
+}
+
 //==============================================================================
 ItineraryVersion Database::itinerary_version(ParticipantId participant) const
 {
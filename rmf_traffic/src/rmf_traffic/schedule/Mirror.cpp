@@ -68,6 +68,12 @@ public:
 
   Version latest_version = 0;
 
+  Implementation(const BucketPolicy& bucket_policy)
+  : timeline(bucket_policy)
+  {
+    // Do nothing
+  }
+
   static void erase_routes(
     const ParticipantId participant,
     ParticipantState& state,
@@ -183,6 +189,45 @@ public:
 
 };
 
+//==============================================================================
+class MirrorVisitRelevanceInspector
+  : public TimelineInspector<Mirror::Implementation::RouteEntry>
+{
+public:
+
+  using RouteEntry = Mirror::Implementation::RouteEntry;
+
+  MirrorVisitRelevanceInspector(const Viewer::Visitor& visitor)
+  : _visitor(visitor)
+  {
+    // Do nothing
+  }
+
+  void inspect(
+    const RouteEntry* entry,
+    const std::function<bool(const RouteEntry&)>& relevant) final
+  {
+    assert(entry);
+    assert(entry->route);
+    if (relevant(*entry))
+    {
+      const bool keep_going = _visitor(
+        Viewer::View::Element{
+          entry->participant,
+          entry->route_id,
+          *entry->route,
+          *entry->description
+        });
+
+      if (!keep_going)
+        finish();
+    }
+  }
+
+private:
+  const Viewer::Visitor& _visitor;
+};
+
 //==============================================================================
 class MirrorCullRelevanceInspector
   : public TimelineInspector<Mirror::Implementation::RouteEntry>
@@ -228,6 +273,44 @@ Viewer::View Mirror::query(
   return Viewer::View::Implementation::make_view(std::move(inspector.routes));
 }
 
+//==============================================================================
+Viewer::View Mirror::query(
+  const std::string& map,
+  const Time lower_time_bound,
+  const Time upper_time_bound,
+  const Query::Participants& participants) const
+{
+  MirrorViewRelevanceInspector inspector;
+  _pimpl->timeline.inspect_timespan(
+    map, &lower_time_bound, &upper_time_bound, participants, inspector);
+  return Viewer::View::Implementation::make_view(std::move(inspector.routes));
+}
+
+//==============================================================================
+bool Mirror::visit(
+  const Query::Spacetime& spacetime,
+  const Query::Participants& participants,
+  const Visitor& visitor) const
+{
+  MirrorVisitRelevanceInspector inspector(visitor);
+  _pimpl->timeline.inspect(spacetime, participants, inspector);
+  return !inspector.finished();
+}
+
+//==============================================================================
+bool Mirror::visit(
+  const std::string& map,
+  const Time lower_time_bound,
+  const Time upper_time_bound,
+  const Query::Participants& participants,
+  const Visitor& visitor) const
+{
+  MirrorVisitRelevanceInspector inspector(visitor);
+  _pimpl->timeline.inspect_timespan(
+    map, &lower_time_bound, &upper_time_bound, participants, inspector);
+  return !inspector.finished();
+}
+
 //==============================================================================
 const std::unordered_set<ParticipantId>& Mirror::participant_ids() const
 {
@@ -273,7 +356,8 @@ std::shared_ptr<const Snapshot> Mirror::snapshot() const
 {
   using SnapshotType =
     SnapshotImplementation<Implementation::RouteEntry,
-      MirrorViewRelevanceInspector
+      MirrorViewRelevanceInspector,
+      MirrorVisitRelevanceInspector
     >;
 
   return std::make_shared<SnapshotType>(
@@ -284,8 +368,8 @@ std::shared_ptr<const Snapshot> Mirror::snapshot() const
 }
 
 //==============================================================================
-Mirror::Mirror()
-: _pimpl(rmf_utils::make_unique_impl<Implementation>())
+Mirror::Mirror(const BucketPolicy& bucket_policy)
+: _pimpl(rmf_utils::make_unique_impl<Implementation>(bucket_policy))
 {
   // Do nothing
 }
@@ -372,6 +456,8 @@ Version Mirror::update(const Patch& patch)
 
       p_it->second.storage.erase(route.route_id);
     }
+
+    _pimpl->timeline.cull(time);
   }
 
   _pimpl->latest_version = patch.latest_version();
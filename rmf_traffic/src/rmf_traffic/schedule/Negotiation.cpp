@@ -149,6 +149,21 @@ public:
     const Query::Spacetime& spacetime,
     const VersionedKeySequence& rollouts) const;
 
+  Viewer::View query(
+    const std::string& map,
+    Time lower_time_bound,
+    Time upper_time_bound,
+    const VersionedKeySequence& rollouts) const;
+
+  /// Gather the routes of the proposal, the chosen rollouts, and the schedule
+  /// into one view. The inspect function is applied to each negotiation
+  /// timeline, and the query function is applied to the schedule viewer.
+  template<typename InspectFn, typename QueryFn>
+  Viewer::View gather(
+    const VersionedKeySequence& chosen_alternatives,
+    InspectFn&& inspect,
+    QueryFn&& query) const;
+
   template<typename... Args>
   static Viewer make(Args&& ... args)
   {
@@ -888,26 +903,27 @@ public:
 } // anonymous namespace
 
 //==============================================================================
-Viewer::View Negotiation::Table::Viewer::Implementation::query(
-  const Query::Spacetime& spacetime,
-  const VersionedKeySequence& chosen_alternatives) const
+template<typename InspectFn, typename QueryFn>
+Viewer::View Negotiation::Table::Viewer::Implementation::gather(
+  const VersionedKeySequence& chosen_alternatives,
+  InspectFn&& inspect,
+  QueryFn&& query) const
 {
-  const auto& all_participants = Query::Participants::make_all();
-
   // Query for the relevant routes that are being negotiated
   NegotiationRelevanceInspector inspector;
-  proposed_timeline->inspect(spacetime, all_participants, inspector);
+  inspect(*proposed_timeline, inspector);
 
   // Query for the routes in the child rollouts that are being considered
   for (const auto& alternative : chosen_alternatives)
   {
-    alternatives_timelines.at(alternative.participant)
-    .at(alternative.version)
-    ->inspect(spacetime, all_participants, inspector);
+    inspect(
+      *alternatives_timelines.at(alternative.participant)
+      .at(alternative.version),
+      inspector);
   }
 
   // Query for the relevant routes that are outside of the negotiation
-  Viewer::View view = schedule_viewer->query(spacetime, *participant_query);
+  Viewer::View view = query(*schedule_viewer);
 
   // Merge them together into a single view
   Viewer::View::Implementation::append_to_view(
@@ -916,6 +932,46 @@ Viewer::View Negotiation::Table::Viewer::Implementation::query(
   return view;
 }
 
+//==============================================================================
+Viewer::View Negotiation::Table::Viewer::Implementation::query(
+  const Query::Spacetime& spacetime,
+  const VersionedKeySequence& chosen_alternatives) const
+{
+  const auto& all_participants = Query::Participants::make_all();
+  return gather(
+    chosen_alternatives,
+    [&](const auto& timeline, NegotiationRelevanceInspector& inspector)
+    {
+      timeline.inspect(spacetime, all_participants, inspector);
+    },
+    [&](const schedule::Viewer& viewer)
+    {
+      return viewer.query(spacetime, *participant_query);
+    });
+}
+
+//==============================================================================
+Viewer::View Negotiation::Table::Viewer::Implementation::query(
+  const std::string& map,
+  const Time lower_time_bound,
+  const Time upper_time_bound,
+  const VersionedKeySequence& chosen_alternatives) const
+{
+  const auto& all_participants = Query::Participants::make_all();
+  return gather(
+    chosen_alternatives,
+    [&](const auto& timeline, NegotiationRelevanceInspector& inspector)
+    {
+      timeline.inspect_timespan(
+        map, &lower_time_bound, &upper_time_bound, all_participants, inspector);
+    },
+    [&](const schedule::Viewer& viewer)
+    {
+      return viewer.query(
+        map, lower_time_bound, upper_time_bound, *participant_query);
+    });
+}
+
 //==============================================================================
 Viewer::View Negotiation::Table::Viewer::query(
   const Query::Spacetime& parameters,
@@ -924,6 +980,16 @@ Viewer::View Negotiation::Table::Viewer::query(
   return _pimpl->query(parameters, alternatives);
 }
 
+//==============================================================================
+Viewer::View Negotiation::Table::Viewer::query(
+  const std::string& map,
+  const Time lower_time_bound,
+  const Time upper_time_bound,
+  const VersionedKeySequence& alternatives) const
+{
+  return _pimpl->query(map, lower_time_bound, upper_time_bound, alternatives);
+}
+
 //==============================================================================
 auto Negotiation::Table::Viewer::alternatives() const -> const AlternativeMap&
 {
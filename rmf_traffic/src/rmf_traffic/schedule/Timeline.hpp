@@ -20,28 +20,107 @@
 
 #include "../DetectConflictInternal.hpp"
 
+#include <rmf_traffic/schedule/BucketPolicy.hpp>
 #include <rmf_traffic/schedule/Query.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <future>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace rmf_traffic {
 namespace schedule {
 
 namespace {
 
-// TODO(MXG): Consider allowing these values to be configured
+// Each cell of the spatial grid inside of a bucket spans 10m x 10m.
+const double SpatialCellSize = 10.0;
 
-// Each Timeline Bucket spans a range of 1 minute.
-const Duration BucketDuration = std::chrono::minutes(1);
+// If the bounding box of an entry would cover more than this many cells of the
+// spatial grid, we will not bother putting it into the grid. Instead it will be
+// stored in a list that always gets checked.
+const std::size_t MaxSpatialCellsPerEntry = 64;
 
-// This constant is used during the creation of the first bucket for a timeline.
-// It's a very minor optimization that avoids making a bucket that will
-// potentially not be very useful.
-const Duration PartialBucketDuration = std::chrono::seconds(50);
+// The list of every entry in a timeline is split into pages of this size so
+// that snapshots only need to copy the pages that have changed.
+const std::size_t TimelinePageSize = 256;
+
+// A region query will only be split across worker threads if each worker would
+// get at least this many candidate routes to check.
+const std::size_t MinCandidatesPerQueryWorker = 32;
 
 } // anonymous namespace
 
+//==============================================================================
+/// A range of cells in the spatial grid of a timeline bucket
+struct SpatialRange
+{
+  int64_t min_x;
+  int64_t min_y;
+  int64_t max_x;
+  int64_t max_y;
+
+  static int64_t to_cell(const double value)
+  {
+    return static_cast<int64_t>(std::floor(value / SpatialCellSize));
+  }
+
+  static SpatialRange make(const internal::BoundingBox& box)
+  {
+    return SpatialRange{
+      to_cell(box.min[0]),
+      to_cell(box.min[1]),
+      to_cell(box.max[0]),
+      to_cell(box.max[1])
+    };
+  }
+
+  /// Returns true if this range covers too many cells to be worth indexing
+  bool oversized() const
+  {
+    const double width = static_cast<double>(max_x - min_x + 1);
+    const double height = static_cast<double>(max_y - min_y + 1);
+    return width * height > static_cast<double>(MaxSpatialCellsPerEntry);
+  }
+
+  struct SpatialCell
+  {
+    int64_t x;
+    int64_t y;
+
+    bool operator==(const SpatialCell& other) const
+    {
+      return x == other.x && y == other.y;
+    }
+  };
+
+  template<typename F>
+  void for_each_cell(F&& f) const
+  {
+    for (int64_t x = min_x; x <= max_x; ++x)
+    {
+      for (int64_t y = min_y; y <= max_y; ++y)
+        f(SpatialCell{x, y});
+    }
+  }
+
+  struct CellHash
+  {
+    std::size_t operator()(const SpatialCell& cell) const
+    {
+      // Cell coordinates will be small numbers, so we just fold the y value
+      // into the upper bits of the x value.
+      const uint64_t x = static_cast<uint64_t>(cell.x);
+      const uint64_t y = static_cast<uint64_t>(cell.y);
+      return std::hash<uint64_t>()(x ^ (y << 32) ^ (y >> 32));
+    }
+  };
+};
+
 //==============================================================================
 struct ParticipantFilter
 {
@@ -101,6 +180,461 @@ struct ParticipantFilter
   };
 };
 
+//==============================================================================
+/// A bucket of entries whose routes are active within a certain time span of a
+/// timeline. We template this on the const-qualified entry type so that a
+/// Timeline and its read-only snapshots can share the same bucket type.
+template<typename ConstEntry>
+struct TimelineBucket
+{
+  using ConstEntryPtr = std::shared_ptr<ConstEntry>;
+
+  /// Keeps track of which buckets an entry has been placed into, and where it
+  /// can be found inside of each of them. This allows the entry to be removed
+  /// from its buckets in constant time, and it allows the timeline to move the
+  /// entry around when it splits or merges buckets.
+  struct Registration
+  {
+    struct Membership
+    {
+      std::weak_ptr<TimelineBucket> bucket;
+
+      // We keep a raw pointer to the bucket so that we can identify it without
+      // locking the weak_ptr.
+      const TimelineBucket* address;
+
+      // The index of the entry inside of the bucket's entries
+      std::size_t slot;
+
+      // The index of the entry inside of each spatial grid cell that it
+      // occupies, in the order that SpatialRange::for_each_cell visits them.
+      // If the range is oversized, this holds only the index of the entry
+      // inside of the oversized list.
+      std::vector<std::size_t> spatial_slots;
+    };
+
+    ConstEntryPtr entry;
+    internal::BoundingBox box;
+    SpatialRange range;
+
+    /// A small number that identifies the route of this entry within the
+    /// timeline. Entries that belong to the same route share the same index.
+    std::size_t route_index = 0;
+
+    /// Membership in the bucket that contains every entry of the timeline
+    Membership all;
+
+    /// Membership in each time bucket of the timeline
+    std::vector<Membership> buckets;
+
+    Membership* find(const TimelineBucket* bucket)
+    {
+      if (all.address == bucket)
+        return &all;
+
+      for (auto& membership : buckets)
+      {
+        // The address of a bucket that has expired might get reused by a new
+        // bucket, so we need to make sure the bucket is still alive.
+        if (membership.address == bucket && !membership.bucket.expired())
+          return &membership;
+      }
+
+      return nullptr;
+    }
+  };
+
+  /// An entry that is stored in a bucket
+  struct Slot
+  {
+    ConstEntryPtr entry;
+    std::size_t route_index;
+
+    // The registration is only meaningful inside of the Timeline that owns
+    // the bucket. Snapshots must never use it.
+    Registration* registration;
+  };
+
+  /// An entry together with the bounding box of its route
+  struct SpatialEntry
+  {
+    ConstEntryPtr entry;
+    std::size_t route_index;
+    internal::BoundingBox box;
+    Registration* registration;
+
+    // Which of the registration's spatial_slots refers to this SpatialEntry
+    std::size_t ordinal;
+  };
+
+  using Membership = typename Registration::Membership;
+  using SpatialEntries = std::vector<SpatialEntry>;
+  using SpatialGrid = std::unordered_map<
+    SpatialRange::SpatialCell, SpatialEntries, SpatialRange::CellHash>;
+
+  /// The span of time that this bucket covers, ending at its key in the
+  /// timeline
+  Duration duration;
+
+  /// Every entry whose route is active during the time span of this bucket
+  std::vector<Slot> entries;
+
+  /// A coarse 2D grid that indexes the entries according to the boxes that
+  /// are swept out by their routes. This lets region queries skip over routes
+  /// that are nowhere near the region.
+  SpatialGrid grid;
+
+  /// Entries whose boxes cover too many grid cells to be worth indexing. These
+  /// will be checked by every region query that reaches this bucket.
+  SpatialEntries oversized;
+
+  /// A read-only copy of this bucket which gets shared by the snapshots of the
+  /// timeline. It is cleared whenever this bucket is modified.
+  std::shared_ptr<TimelineBucket> frozen;
+
+  TimelineBucket(Duration duration_ = Duration(0))
+  : duration(duration_)
+  {
+    // Do nothing
+  }
+
+  /// Get a read-only copy of this bucket. The copy will be reused until the
+  /// next time this bucket is modified, so consecutive snapshots of the
+  /// timeline will only need to copy the buckets that have changed.
+  const std::shared_ptr<TimelineBucket>& freeze()
+  {
+    if (!frozen)
+      frozen = std::make_shared<TimelineBucket>(*this);
+
+    return frozen;
+  }
+
+  /// Discard the read-only copy of this bucket because the bucket has been
+  /// modified.
+  void unfreeze()
+  {
+    frozen = nullptr;
+  }
+
+  /// Add a registered entry to this bucket without putting it in the spatial
+  /// grid. This is used for the bucket that contains every entry.
+  void add_entry(Registration* registration, Membership& membership)
+  {
+    unfreeze();
+    membership.address = this;
+    membership.slot = entries.size();
+    entries.push_back(
+      Slot{registration->entry, registration->route_index, registration});
+  }
+
+  /// Add a registered entry to this bucket
+  void add(Registration* registration, Membership& membership)
+  {
+    add_entry(registration, membership);
+
+    membership.spatial_slots.clear();
+    const auto push = [&](SpatialEntries& spatial_entries)
+      {
+        const std::size_t ordinal = membership.spatial_slots.size();
+        membership.spatial_slots.push_back(spatial_entries.size());
+        spatial_entries.push_back(
+          SpatialEntry{
+            registration->entry,
+            registration->route_index,
+            registration->box,
+            registration,
+            ordinal
+          });
+      };
+
+    if (registration->range.oversized())
+    {
+      push(oversized);
+      return;
+    }
+
+    registration->range.for_each_cell(
+      [&](const SpatialRange::SpatialCell& cell)
+      {
+        push(grid[cell]);
+      });
+  }
+
+  /// Remove a registered entry from this bucket without touching the spatial
+  /// grid. This is used for the bucket that contains every entry.
+  void remove_entry(const Membership& membership)
+  {
+    unfreeze();
+    const std::size_t slot = membership.slot;
+    assert(slot < entries.size());
+
+    if (slot + 1 < entries.size())
+    {
+      entries[slot] = std::move(entries.back());
+      entries[slot].registration->find(this)->slot = slot;
+    }
+
+    entries.pop_back();
+  }
+
+  /// Remove a registered entry from this bucket
+  void remove(const Registration& registration, const Membership& membership)
+  {
+    assert(entries[membership.slot].registration == &registration);
+    remove_entry(membership);
+
+    if (registration.range.oversized())
+    {
+      remove_spatial(oversized, membership.spatial_slots.front());
+      return;
+    }
+
+    std::size_t ordinal = 0;
+    registration.range.for_each_cell(
+      [&](const SpatialRange::SpatialCell& cell)
+      {
+        const auto cell_it = grid.find(cell);
+        assert(cell_it != grid.end());
+
+        remove_spatial(cell_it->second, membership.spatial_slots[ordinal++]);
+        if (cell_it->second.empty())
+          grid.erase(cell_it);
+      });
+  }
+
+private:
+
+  void remove_spatial(SpatialEntries& spatial_entries, const std::size_t slot)
+  {
+    assert(slot < spatial_entries.size());
+
+    if (slot + 1 < spatial_entries.size())
+    {
+      SpatialEntry& moved = spatial_entries[slot];
+      moved = std::move(spatial_entries.back());
+      moved.registration->find(this)->spatial_slots[moved.ordinal] = slot;
+    }
+
+    spatial_entries.pop_back();
+  }
+};
+
+//==============================================================================
+/// Every entry of a timeline, split into pages so that taking a snapshot of the
+/// timeline only needs to copy the pages that have changed. Every page except
+/// for the last one is always kept full.
+template<typename ConstEntry>
+struct TimelinePages
+{
+  using Bucket = TimelineBucket<ConstEntry>;
+  using BucketPtr = std::shared_ptr<Bucket>;
+  using Registration = typename Bucket::Registration;
+  using Membership = typename Bucket::Membership;
+
+  std::vector<BucketPtr> pages;
+
+  /// This gets set whenever anything in the timeline is modified, so that the
+  /// timeline knows when it can reuse its last snapshot.
+  bool modified = true;
+
+  /// The number of entries that currently belong to a route, and the index
+  /// that has been given to the route
+  struct RouteIndex
+  {
+    std::size_t index;
+    std::size_t count;
+  };
+
+  std::unordered_map<ParticipantId, std::unordered_map<RouteId, RouteIndex>>
+  route_indices;
+
+  /// Indices that were given to routes which have since left the timeline, to
+  /// be reused by new routes. This keeps the indices densely packed.
+  std::vector<std::size_t> free_route_indices;
+  std::size_t next_route_index = 0;
+
+  void add(Registration* registration)
+  {
+    registration->route_index = acquire_route_index(*registration->entry);
+
+    if (pages.empty() || pages.back()->entries.size() >= TimelinePageSize)
+      pages.push_back(std::make_shared<Bucket>());
+
+    const BucketPtr& page = pages.back();
+    registration->all.bucket = page;
+    page->add_entry(registration, registration->all);
+    modified = true;
+  }
+
+  void remove(const Registration& registration)
+  {
+    release_route_index(*registration.entry);
+
+    const Membership& membership = registration.all;
+    modified = true;
+    const BucketPtr page = membership.bucket.lock();
+    assert(page);
+
+    const BucketPtr last = pages.back();
+    if (page == last)
+    {
+      page->remove_entry(membership);
+    }
+    else
+    {
+      // Fill in the hole with the very last entry so that the page stays full
+      auto& slot = page->entries[membership.slot];
+      slot = std::move(last->entries.back());
+      last->entries.pop_back();
+
+      Membership& moved = slot.registration->all;
+      moved.bucket = page;
+      moved.address = page.get();
+      moved.slot = membership.slot;
+
+      page->unfreeze();
+      last->unfreeze();
+    }
+
+    if (last->entries.empty())
+      pages.pop_back();
+  }
+
+private:
+
+  std::size_t acquire_route_index(const ConstEntry& entry)
+  {
+    const auto insertion =
+      route_indices[entry.participant].insert({entry.route_id, {0, 0}});
+
+    RouteIndex& route = insertion.first->second;
+    if (insertion.second)
+    {
+      if (free_route_indices.empty())
+      {
+        route.index = next_route_index++;
+      }
+      else
+      {
+        route.index = free_route_indices.back();
+        free_route_indices.pop_back();
+      }
+    }
+
+    ++route.count;
+    return route.index;
+  }
+
+  void release_route_index(const ConstEntry& entry)
+  {
+    const auto p_it = route_indices.find(entry.participant);
+    assert(p_it != route_indices.end());
+
+    const auto r_it = p_it->second.find(entry.route_id);
+    assert(r_it != p_it->second.end());
+
+    if (--r_it->second.count > 0)
+      return;
+
+    free_route_indices.push_back(r_it->second.index);
+    p_it->second.erase(r_it);
+    if (p_it->second.empty())
+      route_indices.erase(p_it);
+  }
+};
+
+//==============================================================================
+/// Remembers which routes have already been inspected during a query. Each
+/// route of a timeline has a dense index, and we stamp the slot of that index
+/// with the epoch of the current query, so checking a route is a single
+/// compare-and-store. Instances are recycled through a thread-local pool and
+/// keep their storage between queries, so once they have grown to fit the
+/// timeline, checking a route does not allocate anything.
+class CheckedRoutes
+{
+public:
+
+  /// Returns true if the route was not already checked during this query
+  bool insert(const std::size_t route_index)
+  {
+    if (route_index >= _stamps.size())
+      _stamps.resize(std::max<std::size_t>(2*route_index + 1, 64), 0);
+
+    uint32_t& stamp = _stamps[route_index];
+    if (stamp == _epoch)
+      return false;
+
+    stamp = _epoch;
+    return true;
+  }
+
+  /// Forget every route that has been checked, without giving up the storage
+  void clear()
+  {
+    if (++_epoch == 0)
+    {
+      // The epoch has wrapped around, so stale stamps could be mistaken for
+      // the new epoch.
+      std::fill(_stamps.begin(), _stamps.end(), 0);
+      _epoch = 1;
+    }
+  }
+
+  /// Gives exclusive use of a CheckedRoutes instance from the pool of the
+  /// current thread, and returns it to the pool when destructed.
+  class Lease
+  {
+  public:
+
+    Lease(std::unique_ptr<CheckedRoutes> checked)
+    : _checked(std::move(checked))
+    {
+      // Do nothing
+    }
+
+    Lease(Lease&&) = default;
+
+    CheckedRoutes& operator*() { return *_checked; }
+    CheckedRoutes* operator->() { return _checked.get(); }
+
+    ~Lease()
+    {
+      if (!_checked)
+        return;
+
+      _checked->clear();
+      pool().push_back(std::move(_checked));
+    }
+
+  private:
+    std::unique_ptr<CheckedRoutes> _checked;
+  };
+
+  static Lease acquire()
+  {
+    auto& p = pool();
+    if (p.empty())
+      return Lease(std::make_unique<CheckedRoutes>());
+
+    auto checked = std::move(p.back());
+    p.pop_back();
+    return Lease(std::move(checked));
+  }
+
+private:
+
+  static std::vector<std::unique_ptr<CheckedRoutes>>& pool()
+  {
+    // Queries can be nested (e.g. an inspector that queries another
+    // timeline), so each thread may need more than one instance at a time.
+    static thread_local std::vector<std::unique_ptr<CheckedRoutes>> p;
+    return p;
+  }
+
+  std::vector<uint32_t> _stamps;
+  uint32_t _epoch = 1;
+};
+
 //==============================================================================
 template<typename Entry>
 class TimelineInspector;
@@ -117,15 +651,18 @@ public:
 public:
 
   using ConstEntryPtr = std::shared_ptr<const Entry>;
-  using Bucket = std::vector<ConstEntryPtr>;
+
+  using Bucket = TimelineBucket<const Entry>;
+  using Pages = TimelinePages<const Entry>;
+  using SpatialEntry = typename Bucket::SpatialEntry;
+  using SpatialEntries = typename Bucket::SpatialEntries;
 
   // We use a shared_ptr for BucketPtr so that the Handle class can hold a
   // weak_ptr to the bucket that contains its entry. If the bucket is ever
   // deleted (e.g. because of a culling) that won't have a negative impact on
   // the Handle's cleanup.
   using BucketPtr = std::shared_ptr<Bucket>;
-  using Checked =
-    std::unordered_map<ParticipantId, std::unordered_set<RouteId>>;
+  using Checked = CheckedRoutes;
 
   // TODO(MXG): Come up with a better name for this data structure than Entries
   using Entries = std::map<Time, BucketPtr>;
@@ -133,7 +670,7 @@ public:
 
   /// Constructor
   TimelineView()
-  : _all_bucket(std::make_shared<Bucket>())
+  : _pages(std::make_shared<Pages>())
   {
     // Do nothing
   }
@@ -144,29 +681,136 @@ public:
     const Query::Spacetime& spacetime,
     const Query::Participants& participants,
     Inspector& inspector) const
+  {
+    visit_participant_filter(
+      participants,
+      [&](const auto& participant_filter)
+      {
+        this->inspect_spacetime(spacetime, participant_filter, inspector);
+      });
+  }
+
+  /// Inspect the timeline for entries that match the query, sharing the work
+  /// of region queries across the given number of worker threads. Other kinds
+  /// of queries, and region queries that are too small to be worth splitting,
+  /// will be inspected on the current thread.
+  ///
+  /// Besides the TimelineInspector interface, the Inspector type must provide
+  ///   Inspector fork() const;
+  ///     which creates an empty inspector with the same settings, and
+  ///   void merge(Inspector&& other);
+  ///     which adds the results of another inspector into this one.
+  ///
+  /// Every route will still be passed to exactly one of the inspectors, so
+  /// merging their results does not need to worry about duplicates.
+  template<typename Inspector>
+  void inspect(
+    const Query::Spacetime& spacetime,
+    const Query::Participants& participants,
+    Inspector& inspector,
+    const std::size_t workers) const
+  {
+    if (workers <= 1 || Query::Spacetime::Mode::Regions != spacetime.get_mode())
+    {
+      inspect(spacetime, participants, inspector);
+      return;
+    }
+
+    visit_participant_filter(
+      participants,
+      [&](const auto& participant_filter)
+      {
+        this->inspect_spacetime_regions_parallel(
+          *spacetime.regions(), participant_filter, inspector, workers);
+      });
+  }
+
+  /// Inspect the entries on one map whose routes are active at some point
+  /// between the given time bounds. This gives the same results as a Timespan
+  /// query for that single map, but the caller does not need to construct a
+  /// Query::Spacetime for it.
+  template<typename Inspector>
+  void inspect_timespan(
+    const std::string& map,
+    const Time* const lower_time_bound,
+    const Time* const upper_time_bound,
+    const Query::Participants& participants,
+    Inspector& inspector) const
+  {
+    const auto map_it = _timelines.find(map);
+    if (map_it == _timelines.end())
+      return;
+
+    const Entries& timeline = map_it->second;
+    visit_participant_filter(
+      participants,
+      [&](const auto& participant_filter)
+      {
+        CheckedRoutes::Lease checked = CheckedRoutes::acquire();
+        this->inspect_entries(
+          make_timespan_relevance(lower_time_bound, upper_time_bound),
+          participant_filter,
+          inspector,
+          get_timeline_begin(timeline, lower_time_bound),
+          get_timeline_end(timeline, upper_time_bound),
+          *checked);
+      });
+  }
+
+  /// Inspect only the given candidate entries, using the same relevance rules
+  /// as inspect(). This is useful when the caller already knows which routes
+  /// it needs to look at, so there is no need to search the buckets.
+  ///
+  /// Each candidate will be passed to the inspector at most once, and there
+  /// should be no more than one candidate per route.
+  template<typename Inspector>
+  void inspect_candidates(
+    const Query::Spacetime& spacetime,
+    const Query::Participants& participants,
+    const std::vector<const Entry*>& candidates,
+    Inspector& inspector) const
+  {
+    const std::function<bool(const Entry&)> relevant =
+      make_relevance(spacetime);
+
+    visit_participant_filter(
+      participants,
+      [&](const auto& participant_filter)
+      {
+        for (const Entry* entry : candidates)
+        {
+          if (participant_filter.ignore(entry->participant))
+            continue;
+
+          inspector.inspect(entry, relevant);
+          if (inspector.finished())
+            return;
+        }
+      });
+  }
+
+  template<typename> friend class Timeline;
+
+protected:
+
+  template<typename F>
+  static void visit_participant_filter(
+    const Query::Participants& participants,
+    F&& f)
   {
     const Query::Participants::Mode mode = participants.get_mode();
 
     if (Query::Participants::Mode::All == mode)
     {
-      inspect_spacetime(
-        spacetime,
-        ParticipantFilter::AllowAll(),
-        inspector);
+      f(ParticipantFilter::AllowAll());
     }
     else if (Query::Participants::Mode::Include == mode)
     {
-      inspect_spacetime(
-        spacetime,
-        ParticipantFilter::Include(participants.include()->get_ids()),
-        inspector);
+      f(ParticipantFilter::Include(participants.include()->get_ids()));
     }
     else if (Query::Participants::Mode::Exclude == mode)
     {
-      inspect_spacetime(
-        spacetime,
-        ParticipantFilter::Exclude(participants.exclude()->get_ids()),
-        inspector);
+      f(ParticipantFilter::Exclude(participants.exclude()->get_ids()));
     }
     else
     {
@@ -178,9 +822,72 @@ public:
     }
   }
 
-  template<typename> friend class Timeline;
+  /// Make a relevance function that judges an entry by the spacetime query
+  /// alone. Unlike the relevance functions used while searching the buckets,
+  /// this also needs to check the map of the entry, because it is not implied
+  /// by where the entry was found.
+  static std::function<bool(const Entry&)> make_relevance(
+    const Query::Spacetime& spacetime)
+  {
+    const Query::Spacetime::Mode mode = spacetime.get_mode();
+    if (Query::Spacetime::Mode::Regions == mode)
+    {
+      const auto* const regions = spacetime.regions();
+      return [regions](const Entry& entry) -> bool
+        {
+          const std::string& map = entry.route->map();
+          rmf_traffic::internal::Spacetime spacetime_data;
+          for (const Region& region : *regions)
+          {
+            if (region.get_map() != map)
+              continue;
+
+            spacetime_data.lower_time_bound = region.get_lower_time_bound();
+            spacetime_data.upper_time_bound = region.get_upper_time_bound();
+            for (auto space_it = region.begin(); space_it != region.end();
+              ++space_it)
+            {
+              spacetime_data.pose = space_it->get_pose();
+              spacetime_data.shape = space_it->get_shape();
+              if (rmf_traffic::internal::detect_conflicts(
+                  entry.description->profile(),
+                  entry.route->trajectory(),
+                  spacetime_data))
+                return true;
+            }
+          }
 
-protected:
+          return false;
+        };
+    }
+    else if (Query::Spacetime::Mode::Timespan == mode)
+    {
+      const auto* const timespan = spacetime.timespan();
+      return [timespan](const Entry& entry) -> bool
+        {
+          if (!timespan->all_maps()
+            && timespan->maps().count(entry.route->map()) == 0)
+            return false;
+
+          const Time* const lower_time_bound =
+            timespan->get_lower_time_bound();
+          const Time* const upper_time_bound =
+            timespan->get_upper_time_bound();
+
+          const Trajectory& trajectory = entry.route->trajectory();
+          assert(trajectory.start_time());
+          if (lower_time_bound && *trajectory.finish_time() < *lower_time_bound)
+            return false;
+
+          if (upper_time_bound && *upper_time_bound < *trajectory.start_time())
+            return false;
+
+          return true;
+        };
+    }
+
+    return [](const Entry&) -> bool { return true; };
+  }
 
   template<typename Inspector, typename ParticipantFilter>
   void inspect_spacetime(
@@ -211,18 +918,24 @@ protected:
     const ParticipantFilter& participant_filter,
     Inspector& inspector) const
   {
-    Checked checked;
+    CheckedRoutes::Lease checked = CheckedRoutes::acquire();
 
     const auto relevant = [](const Entry&) -> bool { return true; };
-    for (const auto& entry : *_all_bucket)
+    for (const auto& page : _pages->pages)
     {
-      if (participant_filter.ignore(entry->participant))
-        continue;
+      for (const auto& slot : page->entries)
+      {
+        const auto& entry = slot.entry;
+        if (participant_filter.ignore(entry->participant))
+          continue;
 
-      if (!checked[entry->participant].insert(entry->route_id).second)
-        continue;
+        if (!checked->insert(slot.route_index))
+          continue;
 
-      inspector.inspect(entry.get(), relevant);
+        inspector.inspect(entry.get(), relevant);
+        if (inspector.finished())
+          return;
+      }
     }
   }
 
@@ -232,7 +945,7 @@ protected:
     const ParticipantFilter& participant_filter,
     Inspector& inspector) const
   {
-    Checked checked;
+    CheckedRoutes::Lease checked = CheckedRoutes::acquire();
 
     rmf_traffic::internal::Spacetime spacetime_data;
     const auto relevant =
@@ -276,30 +989,169 @@ protected:
         spacetime_data.pose = space_it->get_pose();
         spacetime_data.shape = space_it->get_shape();
 
-        inspect_entries(
+        inspect_spatial_entries(
           relevant,
+          internal::get_bounding_box(*space_it),
           participant_filter,
           inspector,
           timeline_begin,
           timeline_end,
-          checked);
+          *checked);
+
+        if (inspector.finished())
+          return;
       }
     }
   }
 
   template<typename Inspector, typename ParticipantFilter>
-  void inspect_spacetime_timespan(
-    const Query::Spacetime::Timespan& timespan,
+  void inspect_spacetime_regions_parallel(
+    const Query::Spacetime::Regions& regions,
     const ParticipantFilter& participant_filter,
-    Inspector& inspector) const
+    Inspector& inspector,
+    const std::size_t workers) const
   {
-    Checked checked;
+    // Finding the candidates only involves cheap bounding box checks, so we do
+    // that on this thread, in the same order as inspect_spacetime_regions().
+    // The narrowphase relevance checks are the expensive part of a region
+    // query, so those are what get shared between the workers.
+    struct Candidate
+    {
+      const Entry* entry;
+      std::size_t space;
+    };
 
-    const Time* const lower_time_bound = timespan.get_lower_time_bound();
-    const Time* const upper_time_bound = timespan.get_upper_time_bound();
+    struct Collector
+    {
+      std::vector<Candidate>& candidates;
+      std::size_t space;
+
+      void inspect(const Entry* entry, const std::function<bool(const Entry&)>&)
+      {
+        candidates.push_back(Candidate{entry, space});
+      }
+
+      bool finished() const
+      {
+        return false;
+      }
+    };
+
+    std::vector<rmf_traffic::internal::Spacetime> spaces;
+    std::vector<Candidate> candidates;
+    Collector collector{candidates, 0};
+    const std::function<bool(const Entry&)> unused;
+    CheckedRoutes::Lease checked = CheckedRoutes::acquire();
+
+    for (const Region& region : regions)
+    {
+      const auto map_it = _timelines.find(region.get_map());
+      if (map_it == _timelines.end())
+        continue;
+
+      const Entries& timeline = map_it->second;
+      const Time* const lower_time_bound = region.get_lower_time_bound();
+      const Time* const upper_time_bound = region.get_upper_time_bound();
+
+      const auto timeline_begin =
+        get_timeline_begin(timeline, lower_time_bound);
+
+      const auto timeline_end =
+        get_timeline_end(timeline, upper_time_bound);
+
+      if (timeline_begin == timeline_end)
+        continue;
+
+      for (auto space_it = region.begin(); space_it != region.end(); ++space_it)
+      {
+        collector.space = spaces.size();
+        spaces.push_back(
+          rmf_traffic::internal::Spacetime{
+            lower_time_bound,
+            upper_time_bound,
+            space_it->get_pose(),
+            space_it->get_shape()
+          });
+
+        inspect_spatial_entries(
+          unused,
+          internal::get_bounding_box(*space_it),
+          participant_filter,
+          collector,
+          timeline_begin,
+          timeline_end,
+          *checked);
+      }
+    }
+
+    const auto run = [&](Inspector& worker, std::size_t begin, std::size_t end)
+      {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+          const Candidate& candidate = candidates[i];
+          const rmf_traffic::internal::Spacetime& spacetime_data =
+            spaces[candidate.space];
+
+          const std::function<bool(const Entry&)> relevant =
+            [&spacetime_data](const Entry& entry) -> bool
+            {
+              return rmf_traffic::internal::detect_conflicts(
+                entry.description->profile(),
+                entry.route->trajectory(),
+                spacetime_data);
+            };
+
+          worker.inspect(candidate.entry, relevant);
+        }
+      };
+
+    const std::size_t num_workers = std::min(
+      workers, candidates.size()/MinCandidatesPerQueryWorker);
+
+    if (num_workers <= 1)
+    {
+      run(inspector, 0, candidates.size());
+      return;
+    }
+
+    // The first share of the candidates goes to the inspector that we were
+    // given, and the rest go to forks of it which get merged back in order.
+    const std::size_t share = (candidates.size() + num_workers - 1)/num_workers;
+    std::vector<Inspector> forks;
+    forks.reserve(num_workers - 1);
+    for (std::size_t w = 1; w < num_workers; ++w)
+      forks.push_back(inspector.fork());
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(forks.size());
+    for (std::size_t w = 1; w < num_workers; ++w)
+    {
+      const std::size_t begin = std::min(w*share, candidates.size());
+      const std::size_t end = std::min(begin + share, candidates.size());
+      Inspector& fork = forks[w-1];
+      futures.emplace_back(
+        std::async(
+          std::launch::async,
+          [&run, &fork, begin, end]() { run(fork, begin, end); }));
+    }
+
+    run(inspector, 0, std::min(share, candidates.size()));
+
+    for (auto& future : futures)
+      future.get();
 
-    const auto relevant = [&lower_time_bound, &upper_time_bound](
-      const Entry& entry) -> bool
+    for (auto& fork : forks)
+      inspector.merge(std::move(fork));
+  }
+
+  /// Make a relevance function that checks whether the route of an entry is
+  /// active between the time bounds. This is small enough to fit inside of a
+  /// std::function without any heap allocation.
+  static auto make_timespan_relevance(
+    const Time* const lower_time_bound,
+    const Time* const upper_time_bound)
+  {
+    return [lower_time_bound, upper_time_bound](const Entry& entry) -> bool
       {
         const Trajectory& trajectory = entry.route->trajectory();
         assert(trajectory.start_time());
@@ -311,6 +1163,21 @@ protected:
 
         return true;
       };
+  }
+
+  template<typename Inspector, typename ParticipantFilter>
+  void inspect_spacetime_timespan(
+    const Query::Spacetime::Timespan& timespan,
+    const ParticipantFilter& participant_filter,
+    Inspector& inspector) const
+  {
+    CheckedRoutes::Lease checked = CheckedRoutes::acquire();
+
+    const Time* const lower_time_bound = timespan.get_lower_time_bound();
+    const Time* const upper_time_bound = timespan.get_upper_time_bound();
+
+    const std::function<bool(const Entry&)> relevant =
+      make_timespan_relevance(lower_time_bound, upper_time_bound);
 
     if (timespan.all_maps())
     {
@@ -323,7 +1190,10 @@ protected:
           inspector,
           get_timeline_begin(timeline, lower_time_bound),
           get_timeline_end(timeline, upper_time_bound),
-          checked);
+          *checked);
+
+        if (inspector.finished())
+          return;
       }
     }
     else
@@ -342,7 +1212,10 @@ protected:
           inspector,
           get_timeline_begin(timeline, lower_time_bound),
           get_timeline_end(timeline, upper_time_bound),
-          checked);
+          *checked);
+
+        if (inspector.finished())
+          return;
       }
     }
   }
@@ -361,18 +1234,88 @@ protected:
     {
       const Bucket& bucket = *timeline_it->second;
 
-      auto entry_it = bucket.begin();
-      for (; entry_it != bucket.end(); ++entry_it)
+      auto entry_it = bucket.entries.begin();
+      for (; entry_it != bucket.entries.end(); ++entry_it)
       {
-        const Entry* entry = entry_it->get();
+        const Entry* entry = entry_it->entry.get();
 
         if (participant_filter.ignore(entry->participant))
           continue;
 
-        if (!checked[entry->participant].insert(entry->route_id).second)
+        if (!checked.insert(entry_it->route_index))
           continue;
 
         inspector.inspect(entry, relevant);
+        if (inspector.finished())
+          return;
+      }
+    }
+  }
+
+  template<typename Inspector, typename ParticipantFilter>
+  void inspect_spatial_entries(
+    const std::function<bool(const Entry&)>& relevant,
+    const internal::BoundingBox& region_box,
+    const ParticipantFilter& participant_filter,
+    Inspector& inspector,
+    const typename Entries::const_iterator& timeline_begin,
+    const typename Entries::const_iterator& timeline_end,
+    Checked& checked) const
+  {
+    const auto inspect_spatial_entry =
+      [&](const SpatialEntry& spatial_entry)
+      {
+        // This broadphase check lets us skip the narrowphase collision
+        // detection of the relevance function for routes that are nowhere
+        // near the region.
+        if (!internal::overlap(spatial_entry.box, region_box))
+          return;
+
+        if (inspector.finished())
+          return;
+
+        const Entry* entry = spatial_entry.entry.get();
+        if (participant_filter.ignore(entry->participant))
+          return;
+
+        if (!checked.insert(spatial_entry.route_index))
+          return;
+
+        inspector.inspect(entry, relevant);
+      };
+
+    const SpatialRange range = SpatialRange::make(region_box);
+    const bool search_cells = !range.oversized();
+
+    auto timeline_it = timeline_begin;
+    for (; timeline_it != timeline_end && !inspector.finished(); ++timeline_it)
+    {
+      const Bucket& bucket = *timeline_it->second;
+      for (const auto& spatial_entry : bucket.oversized)
+        inspect_spatial_entry(spatial_entry);
+
+      if (search_cells)
+      {
+        range.for_each_cell(
+          [&](const SpatialRange::SpatialCell& cell)
+          {
+            const auto cell_it = bucket.grid.find(cell);
+            if (cell_it == bucket.grid.end())
+              return;
+
+            for (const auto& spatial_entry : cell_it->second)
+              inspect_spatial_entry(spatial_entry);
+          });
+      }
+      else
+      {
+        // The region is so large that it is cheaper to go through the cells
+        // that are occupied than to look up every cell in the region.
+        for (const auto& cell : bucket.grid)
+        {
+          for (const auto& spatial_entry : cell.second)
+            inspect_spatial_entry(spatial_entry);
+        }
       }
     }
   }
@@ -400,7 +1343,7 @@ protected:
   }
 
   MapNameToEntries _timelines;
-  BucketPtr _all_bucket;
+  std::shared_ptr<Pages> _pages;
 };
 
 //==============================================================================
@@ -413,69 +1356,98 @@ public:
   using Bucket = typename TimelineView<Entry>::Bucket;
   using BucketPtr = typename TimelineView<Entry>::BucketPtr;
   using Entries = typename TimelineView<Entry>::Entries;
+  using Pages = typename TimelineView<Entry>::Pages;
+  using Registration = typename Bucket::Registration;
+  using Membership = typename Bucket::Membership;
+  using Slot = typename Bucket::Slot;
 
   /// This Timeline::Handle class allows us to use RAII so that when an Entry is
   /// deleted it will automatically be removed from any of its timeline buckets.
   struct Handle
   {
-    Handle(
-      ConstEntryPtr entry,
-      std::vector<std::weak_ptr<Bucket>> buckets)
-    : _entry(std::move(entry)),
-      _buckets(std::move(buckets))
+    Handle(ConstEntryPtr entry, std::weak_ptr<Pages> pages)
+    : _registration{
+        std::move(entry), internal::void_box(), {0, 0, -1, -1}, 0, {}, {}},
+      _pages(std::move(pages))
     {
       // Do nothing
     }
 
     ~Handle()
     {
-      for (const auto& b : _buckets)
-      {
-        BucketPtr bucket = b.lock();
-        if (!bucket)
-          continue;
+      if (const auto pages = _pages.lock())
+        pages->remove(_registration);
 
-        const auto it = std::find(bucket->begin(), bucket->end(), _entry);
-        if (it != bucket->end())
-          bucket->erase(it);
+      for (const auto& membership : _registration.buckets)
+      {
+        if (const BucketPtr bucket = membership.bucket.lock())
+          bucket->remove(_registration, membership);
       }
     }
 
   private:
-    ConstEntryPtr _entry;
-    std::vector<std::weak_ptr<Bucket>> _buckets;
+    friend class Timeline<Entry>;
+    Registration _registration;
+    std::weak_ptr<Pages> _pages;
   };
 
+  /// Constructor
+  Timeline(const BucketPolicy& policy = BucketPolicy())
+  : _bucket_duration(policy.bucket_duration()),
+    // This is used during the creation of the first bucket for a timeline.
+    // It's a very minor optimization that avoids making a bucket that will
+    // potentially not be very useful.
+    _partial_bucket_duration(policy.bucket_duration() * 5 / 6),
+    _adaptive(policy.adaptive()),
+    _split_threshold(policy.split_threshold()),
+    _merge_threshold(policy.merge_threshold()),
+    _min_bucket_duration(policy.min_bucket_duration()),
+    _max_bucket_duration(policy.max_bucket_duration())
+  {
+    // Do nothing
+  }
+
   /// Insert a new entry into the timeline
   std::shared_ptr<Handle> insert(
     const std::shared_ptr<Entry>& entry)
   {
-    std::vector<std::weak_ptr<Bucket>> buckets;
-    this->_all_bucket->push_back(entry);
-    buckets.emplace_back(this->_all_bucket);
+    auto handle = std::make_shared<Handle>(entry, this->_pages);
+    Registration& registration = handle->_registration;
+    this->_pages->add(&registration);
 
-    if (entry->route && entry->route->trajectory().start_time())
-    {
-      const Time start_time = *entry->route->trajectory().start_time();
-      const Time finish_time = *entry->route->trajectory().finish_time();
-      const std::string& map_name = entry->route->map();
+    if (!entry->route || !entry->route->trajectory().start_time())
+      return handle;
+
+    const Trajectory& trajectory = entry->route->trajectory();
+    const Time start_time = *trajectory.start_time();
+    const Time finish_time = *trajectory.finish_time();
+    const std::string& map_name = entry->route->map();
+
+    registration.box =
+      internal::get_bounding_box(trajectory, entry->description->profile());
+    registration.range = SpatialRange::make(registration.box);
+
+    const auto map_it = this->_timelines.insert(
+      std::make_pair(map_name, Entries())).first;
 
-      const auto map_it = this->_timelines.insert(
-        std::make_pair(map_name, Entries())).first;
+    Entries& timeline = map_it->second;
 
-      Entries& timeline = map_it->second;
+    const auto start_it = get_timeline_iterator(timeline, start_time);
+    const auto end_it = ++get_timeline_iterator(timeline, finish_time);
 
-      const auto start_it = get_timeline_iterator(timeline, start_time);
-      const auto end_it = ++get_timeline_iterator(timeline, finish_time);
+    for (auto it = start_it; it != end_it; ++it)
+      join(registration, it->second);
 
+    if (_adaptive)
+    {
       for (auto it = start_it; it != end_it; ++it)
       {
-        it->second->push_back(entry);
-        buckets.emplace_back(it->second);
+        if (it->second->entries.size() > _split_threshold)
+          split(timeline, it);
       }
     }
 
-    return std::make_shared<Handle>(entry, std::move(buckets));
+    return handle;
   }
 
   void cull(const Time time)
@@ -492,49 +1464,63 @@ public:
         TimelineView<Entry>::get_timeline_begin(timeline, &time);
 
       if (end_it != timeline.begin())
+      {
         timeline.erase(timeline.begin(), end_it);
+        this->_pages->modified = true;
+      }
+
+      if (_adaptive)
+        merge_sparse_buckets(timeline);
     }
   }
 
   /// Create an immutable snapshot of the current timeline. A single instance of
   /// the snapshot can be safely used by multiple threads simultaneously.
+  ///
+  /// Buckets that have not changed since the last snapshot will be shared with
+  /// it, and if nothing at all has changed, the last snapshot will simply be
+  /// returned again.
+  ///
+  /// Concurrent calls to this function are safe, but it must not be called
+  /// while the timeline is being modified.
   std::shared_ptr<const TimelineView<const Entry>> snapshot() const
   {
-    // TODO(MXG): Consider whether we could use plain std::vector<Bucket>
-    // instances instead of std::vector<std::shared_ptr<Bucket>> in the snapshot
-    // to reduce how many heap allocations are needed, and to lessen the cache
-    // misses. The tricky part is this may cost us more when copying the maps.
-
-    // TODO(MXG): Consider whether there's a safe way to cache a snapshot. The
-    // main problem I see is that we don't have a good way of knowing when an
-    // entry gets removed right now, so we wouldn't know to update the snapshot
-    // when an entry gets taken out.
-
+    // The memoized snapshot, the frozen bucket copies, and the modified flag
+    // are all written here even though this is a const function.
+    std::lock_guard<std::mutex> lock(_snapshot_mutex);
+    if (_last_snapshot && !this->_pages->modified)
+      return _last_snapshot;
+
+    // TODO(MXG): We still need to copy the map structure of each timeline. If
+    // that ever becomes a bottleneck, we could consider a persistent map.
     std::shared_ptr<TimelineView<const Entry>> result =
       std::make_shared<TimelineView<const Entry>>();
 
-    // Make a deep copy of the buckets so that adding/removing entries from the
-    // source bucket does not impact the snapshot
-    result->_timelines = this->_timelines;
-    for (auto& map_scope : result->_timelines)
+    for (const auto& map_scope : this->_timelines)
     {
-      for (auto& time_scope : map_scope.second)
+      auto& timeline = result->_timelines[map_scope.first];
+      for (const auto& time_scope : map_scope.second)
       {
-        auto& bucket = time_scope.second;
-        bucket = std::make_shared<Bucket>(*bucket);
+        timeline.emplace_hint(
+          timeline.end(), time_scope.first, time_scope.second->freeze());
       }
     }
 
-    result->_all_bucket = std::make_shared<Bucket>(*result->_all_bucket);
+    auto& pages = result->_pages->pages;
+    pages.reserve(this->_pages->pages.size());
+    for (const auto& page : this->_pages->pages)
+      pages.push_back(page->freeze());
 
+    this->_pages->modified = false;
+    _last_snapshot = result;
     return result;
   }
 
 private:
 
   //============================================================================
-  static typename Entries::iterator get_timeline_iterator(
-    Entries& timeline, const Time time)
+  typename Entries::iterator get_timeline_iterator(
+    Entries& timeline, const Time time) const
   {
     auto start_it = timeline.lower_bound(time);
 
@@ -547,34 +1533,160 @@ private:
         return timeline.insert(
           timeline.end(),
           std::make_pair(
-            time + PartialBucketDuration,
-            std::make_shared<Bucket>()));
+            time + _partial_bucket_duration,
+            std::make_shared<Bucket>(_bucket_duration)));
       }
 
       auto last_it = --timeline.end();
       while (last_it->first < time)
       {
+        const Duration duration = fill_duration(time - last_it->first);
         last_it = timeline.insert(
           timeline.end(),
           std::make_pair(
-            last_it->first + BucketDuration,
-            std::make_shared<Bucket>()));
+            last_it->first + duration,
+            std::make_shared<Bucket>(duration)));
       }
 
       return last_it;
     }
 
-    while (time + BucketDuration < start_it->first)
+    while (time < start_it->first - start_it->second->duration)
     {
+      const Time end = start_it->first - start_it->second->duration;
+      const Duration duration = fill_duration(end - time);
       start_it = timeline.insert(
         start_it,
-        std::make_pair(
-          start_it->first - BucketDuration,
-          std::make_shared<Bucket>()));
+        std::make_pair(end, std::make_shared<Bucket>(duration)));
     }
 
     return start_it;
   }
+
+  //============================================================================
+  /// Decide how long a new bucket should be when the timeline needs to be
+  /// stretched across a gap to reach a new time.
+  Duration fill_duration(const Duration gap) const
+  {
+    // In adaptive mode we will cover most of a long gap with a single wide
+    // bucket, and then leave one bucket of nominal size at the far end of the
+    // gap, which is where the new entry is being inserted.
+    if (_adaptive && gap > 2*_bucket_duration)
+      return std::min(_max_bucket_duration, gap - _bucket_duration);
+
+    return _bucket_duration;
+  }
+
+  //============================================================================
+  /// Split the bucket at the given iterator into two halves. Entries will be
+  /// sorted into whichever halves their routes are active in.
+  void split(Entries& timeline, const typename Entries::iterator& it)
+  {
+    const BucketPtr upper = it->second;
+    const Duration half = upper->duration / 2;
+    if (half < _min_bucket_duration)
+      return;
+
+    const Time mid = it->first - upper->duration + half;
+    const BucketPtr lower = std::make_shared<Bucket>(half);
+    upper->duration -= half;
+    upper->unfreeze();
+    timeline.insert(it, std::make_pair(mid, lower));
+    this->_pages->modified = true;
+
+    std::vector<Slot> slots;
+    std::swap(slots, upper->entries);
+    upper->grid.clear();
+    upper->oversized.clear();
+
+    for (const Slot& slot : slots)
+    {
+      const Trajectory& trajectory = slot.entry->route->trajectory();
+      Registration* const registration = slot.registration;
+
+      // Each entry belongs in every bucket from the lower_bound of its start
+      // time to the lower_bound of its finish time.
+      if (*trajectory.start_time() <= mid)
+        join(*registration, lower);
+
+      if (mid < *trajectory.finish_time())
+        upper->add(registration, *registration->find(upper.get()));
+      else
+        forget(*registration, upper.get());
+    }
+  }
+
+  //============================================================================
+  /// Merge neighboring buckets that are holding very few entries
+  void merge_sparse_buckets(Entries& timeline)
+  {
+    if (timeline.empty())
+      return;
+
+    auto lower_it = timeline.begin();
+    auto upper_it = std::next(lower_it);
+    while (upper_it != timeline.end())
+    {
+      const BucketPtr lower = lower_it->second;
+      const BucketPtr upper = upper_it->second;
+      if (lower->entries.size() + upper->entries.size() < _merge_threshold
+        && lower->duration + upper->duration <= _max_bucket_duration)
+      {
+        // The upper bucket will absorb the lower bucket
+        upper->duration += lower->duration;
+        upper->unfreeze();
+        this->_pages->modified = true;
+        for (const Slot& slot : lower->entries)
+        {
+          Registration& registration = *slot.registration;
+          forget(registration, lower.get());
+
+          if (!registration.find(upper.get()))
+            join(registration, upper);
+        }
+
+        timeline.erase(lower_it);
+      }
+
+      lower_it = upper_it++;
+    }
+  }
+
+  //============================================================================
+  /// Add a registered entry to a bucket
+  static void join(Registration& registration, const BucketPtr& bucket)
+  {
+    registration.buckets.push_back(Membership{bucket, bucket.get(), 0, {}});
+    bucket->add(&registration, registration.buckets.back());
+  }
+
+  //============================================================================
+  /// Remove a bucket from the list of buckets that a registration belongs to.
+  /// This does not remove the entry from the bucket itself.
+  static void forget(Registration& registration, const Bucket* bucket)
+  {
+    auto& buckets = registration.buckets;
+    const auto it = std::find_if(
+      buckets.begin(), buckets.end(),
+      [&](const Membership& membership)
+      {
+        return membership.address == bucket && !membership.bucket.expired();
+      });
+
+    if (it != buckets.end())
+      buckets.erase(it);
+  }
+
+  Duration _bucket_duration;
+  Duration _partial_bucket_duration;
+  bool _adaptive;
+  std::size_t _split_threshold;
+  std::size_t _merge_threshold;
+  Duration _min_bucket_duration;
+  Duration _max_bucket_duration;
+
+  mutable std::shared_ptr<const TimelineView<const Entry>> _last_snapshot;
+  mutable std::mutex _snapshot_mutex;
 };
 
 //==============================================================================
@@ -587,7 +1699,25 @@ public:
     const Entry* entry,
     const std::function<bool(const Entry& entry)>& relevant) = 0;
 
+  /// The timeline will stop giving entries to this inspector once this
+  /// returns true.
+  bool finished() const
+  {
+    return _finished;
+  }
+
   virtual ~TimelineInspector() = default;
+
+protected:
+
+  /// Tell the timeline that this inspector does not need any more entries
+  void finish()
+  {
+    _finished = true;
+  }
+
+private:
+  bool _finished = false;
 };
 
 
@@ -56,6 +56,47 @@ std::size_t Viewer::View::size() const
   return _pimpl->elements.size();
 }
 
+//==============================================================================
+auto Viewer::query(
+  const std::string& map,
+  const Time lower_time_bound,
+  const Time upper_time_bound,
+  const Query::Participants& participants) const -> View
+{
+  Query::Spacetime spacetime;
+  spacetime.query_timespan({map}, lower_time_bound, upper_time_bound);
+  return query(spacetime, participants);
+}
+
+//==============================================================================
+bool Viewer::visit(
+  const Query::Spacetime& spacetime,
+  const Query::Participants& participants,
+  const Visitor& visitor) const
+{
+  const View view = query(spacetime, participants);
+  for (const auto& element : view)
+  {
+    if (!visitor(element))
+      return false;
+  }
+
+  return true;
+}
+
+//==============================================================================
+bool Viewer::visit(
+  const std::string& map,
+  const Time lower_time_bound,
+  const Time upper_time_bound,
+  const Query::Participants& participants,
+  const Visitor& visitor) const
+{
+  Query::Spacetime spacetime;
+  spacetime.query_timespan({map}, lower_time_bound, upper_time_bound);
+  return visit(spacetime, participants, visitor);
+}
+
 } // namespace schedule
 
 
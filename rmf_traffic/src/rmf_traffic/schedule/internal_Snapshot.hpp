@@ -27,7 +27,10 @@ namespace rmf_traffic {
 namespace schedule {
 
 //==============================================================================
-template<typename RouteEntry, typename QueryInspector>
+template<
+  typename RouteEntry,
+  typename QueryInspector,
+  typename VisitInspector>
 class SnapshotImplementation : public Snapshot
 {
 public:
@@ -52,6 +55,41 @@ public:
     return Viewer::View::Implementation::make_view(std::move(inspector.routes));
   }
 
+  View query(
+    const std::string& map,
+    const Time lower_time_bound,
+    const Time upper_time_bound,
+    const Query::Participants& participants) const final
+  {
+    QueryInspector inspector;
+    _timeline->inspect_timespan(
+      map, &lower_time_bound, &upper_time_bound, participants, inspector);
+    return Viewer::View::Implementation::make_view(std::move(inspector.routes));
+  }
+
+  bool visit(
+    const Query::Spacetime& spacetime,
+    const Query::Participants& participants,
+    const Visitor& visitor) const final
+  {
+    VisitInspector inspector(visitor);
+    _timeline->inspect(spacetime, participants, inspector);
+    return !inspector.finished();
+  }
+
+  bool visit(
+    const std::string& map,
+    const Time lower_time_bound,
+    const Time upper_time_bound,
+    const Query::Participants& participants,
+    const Visitor& visitor) const final
+  {
+    VisitInspector inspector(visitor);
+    _timeline->inspect_timespan(
+      map, &lower_time_bound, &upper_time_bound, participants, inspector);
+    return !inspector.finished();
+  }
+
   const std::unordered_set<ParticipantId>& participant_ids() const final
   {
     return _ids;
@@ -16,6 +16,7 @@
 */
 
 #include <rmf_traffic/agv/Planner.hpp>
+#include <rmf_traffic/agv/debug/Planner.hpp>
 #include <rmf_traffic/schedule/Database.hpp>
 
 #include <rmf_traffic/DetectConflict.hpp>
@@ -27,6 +28,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <thread>
 
 // TODO(MXG): Move performance testing content into a performance test folder
@@ -2437,3 +2439,457 @@ SCENARIO("Test starts using graph with non-colinear waypoints")
     // start2 has the shortest duration
   }
 }
+
+SCENARIO("Precomputed planner heuristics", "[heuristics]")
+{
+  using Planner = rmf_traffic::agv::Planner;
+
+  const std::string test_map_name = "test_map";
+  rmf_traffic::agv::Graph graph;
+  graph.add_waypoint(test_map_name, {-5, -5}); // 0
+  graph.add_waypoint(test_map_name, { 0, -5}); // 1
+  graph.add_waypoint(test_map_name, { 5, -5}); // 2
+  graph.add_waypoint(test_map_name, {10, -5}); // 3
+  graph.add_waypoint(test_map_name, { 0, 0}); // 4
+  graph.add_waypoint(test_map_name, {10, 0}); // 5
+
+  auto add_bidir_lane = [&](const std::size_t w0, const std::size_t w1)
+    {
+      graph.add_lane(w0, w1);
+      graph.add_lane(w1, w0);
+    };
+
+  add_bidir_lane(0, 1);
+  add_bidir_lane(1, 2);
+  add_bidir_lane(2, 3);
+  add_bidir_lane(1, 4);
+  add_bidir_lane(3, 5);
+
+  const rmf_traffic::Profile profile = create_test_profile(UnitCircle);
+  const rmf_traffic::agv::VehicleTraits traits(
+    {0.7, 0.3}, {1.0, 0.45}, profile);
+
+  const Planner::Options options{nullptr};
+
+  Planner::Configuration lazy_config{graph, traits};
+  CHECK_FALSE(lazy_config.precompute_heuristics());
+  Planner lazy_planner{lazy_config, options};
+
+  Planner::Configuration precompute_config{graph, traits};
+  precompute_config.precompute_heuristics(true);
+  CHECK(precompute_config.precompute_heuristics());
+  Planner precompute_planner{precompute_config, options};
+
+  const rmf_traffic::Time start_time = std::chrono::steady_clock::now();
+  const Planner::Start start{start_time, 0, 0.0};
+  const Planner::Goal goal{5};
+
+  const auto lazy_plan = lazy_planner.plan(start, goal);
+  REQUIRE(lazy_plan);
+
+  const auto precomputed_plan = precompute_planner.plan(start, goal);
+  REQUIRE(precomputed_plan);
+  CHECK(lazy_plan->get_itinerary().back().trajectory().duration()
+    == precomputed_plan->get_itinerary().back().trajectory().duration());
+
+  WHEN("Heuristics are saved and loaded into a new planner")
+  {
+    std::stringstream stream;
+    precompute_planner.save_heuristics(stream);
+
+    Planner loaded_planner{lazy_config, options};
+    loaded_planner.load_heuristics(stream);
+
+    const auto loaded_plan = loaded_planner.plan(start, goal);
+    REQUIRE(loaded_plan);
+    CHECK(lazy_plan->get_itinerary().back().trajectory().duration()
+      == loaded_plan->get_itinerary().back().trajectory().duration());
+  }
+
+  WHEN("Heuristics are loaded for a different graph")
+  {
+    std::stringstream stream;
+    precompute_planner.save_heuristics(stream);
+
+    rmf_traffic::agv::Graph other_graph = graph;
+    other_graph.add_waypoint(test_map_name, {30, 30});
+    Planner other_planner{
+      Planner::Configuration{other_graph, traits},
+      options
+    };
+
+    CHECK_THROWS_AS(
+      other_planner.load_heuristics(stream), std::invalid_argument);
+  }
+
+  WHEN("Heuristics are loaded for a graph of the same size")
+  {
+    std::stringstream stream;
+    precompute_planner.save_heuristics(stream);
+
+    // Moving a waypoint changes the costs without changing the waypoint count
+    rmf_traffic::agv::Graph moved_graph = graph;
+    moved_graph.get_waypoint(5).set_location({10, 5});
+    Planner moved_planner{
+      Planner::Configuration{moved_graph, traits},
+      options
+    };
+
+    CHECK_THROWS_AS(
+      moved_planner.load_heuristics(stream), std::invalid_argument);
+  }
+
+  WHEN("Heuristics are loaded for different vehicle traits")
+  {
+    std::stringstream stream;
+    precompute_planner.save_heuristics(stream);
+
+    const rmf_traffic::agv::VehicleTraits slow_traits(
+      {0.35, 0.3}, {1.0, 0.45}, profile);
+    Planner slow_planner{
+      Planner::Configuration{graph, slow_traits},
+      options
+    };
+
+    CHECK_THROWS_AS(
+      slow_planner.load_heuristics(stream), std::invalid_argument);
+  }
+
+  WHEN("The input is not serialized heuristics")
+  {
+    std::stringstream stream("not a heuristic table");
+    CHECK_THROWS_AS(
+      lazy_planner.load_heuristics(stream), std::invalid_argument);
+  }
+}
+
+SCENARIO("Rotation-aware planner heuristic", "[heuristics]")
+{
+  using Planner = rmf_traffic::agv::Planner;
+
+  const std::string test_map_name = "test_map";
+  rmf_traffic::agv::Graph graph;
+  graph.add_waypoint(test_map_name, { 0, 0}); // 0
+  graph.add_waypoint(test_map_name, {10, 0}); // 1
+  graph.add_waypoint(test_map_name, {10, 10}); // 2
+  graph.add_lane(0, 1);
+  graph.add_lane(1, 2);
+
+  const rmf_traffic::Profile profile = create_test_profile(UnitCircle);
+  const rmf_traffic::agv::VehicleTraits traits(
+    {0.7, 0.3}, {1.0, 0.45}, profile);
+
+  const Planner::Options options{nullptr};
+  Planner planner{Planner::Configuration{graph, traits}, options};
+
+  const rmf_traffic::Time start_time = std::chrono::steady_clock::now();
+
+  // The vehicle must turn before leaving waypoint 0, at waypoint 1, and again
+  // at waypoint 2 to reach the goal orientation.
+  const Planner::Start start{start_time, 0, M_PI/2.0};
+  const Planner::Goal goal{2, M_PI};
+
+  const auto translation_only = rmf_traffic::agv::Interpolate::positions(
+    traits, start_time, {{0, 0, 0}, {10, 0, 0}, {10, 10, 0}});
+  const double translation_cost =
+    rmf_traffic::time::to_seconds(translation_only.duration());
+
+  auto progress =
+    rmf_traffic::agv::Planner::Debug(planner).begin({start}, goal, options);
+  REQUIRE(progress);
+  const double initial_estimate =
+    progress.queue().top()->remaining_cost_estimate;
+
+  const auto plan = planner.plan(start, goal);
+  REQUIRE(plan);
+  const double plan_cost = rmf_traffic::time::to_seconds(
+    plan->get_itinerary().back().trajectory().back().time() - start_time);
+
+  // The estimate accounts for the turns, but must never exceed the real cost.
+  CHECK(translation_cost < initial_estimate);
+  CHECK(initial_estimate <= plan_cost + 1e-6);
+}
+
+SCENARIO("Concurrent plans share one heuristic cache", "[heuristics]")
+{
+  using Planner = rmf_traffic::agv::Planner;
+
+  const std::string test_map_name = "test_map";
+  rmf_traffic::agv::Graph graph;
+  for (std::size_t i = 0; i < 5; ++i)
+  {
+    for (std::size_t j = 0; j < 5; ++j)
+      graph.add_waypoint(test_map_name, {5.0*i, 5.0*j});
+  }
+
+  for (std::size_t i = 0; i < 5; ++i)
+  {
+    for (std::size_t j = 0; j < 5; ++j)
+    {
+      const std::size_t wp = 5*i + j;
+      if (i < 4)
+      {
+        graph.add_lane(wp, wp + 5);
+        graph.add_lane(wp + 5, wp);
+      }
+
+      if (j < 4)
+      {
+        graph.add_lane(wp, wp + 1);
+        graph.add_lane(wp + 1, wp);
+      }
+    }
+  }
+
+  const rmf_traffic::Profile profile = create_test_profile(UnitCircle);
+  const rmf_traffic::agv::VehicleTraits traits(
+    {0.7, 0.3}, {1.0, 0.45}, profile);
+
+  const Planner planner{
+    Planner::Configuration{graph, traits},
+    Planner::Options{nullptr}
+  };
+
+  const rmf_traffic::Time start_time = std::chrono::steady_clock::now();
+  const std::size_t num_threads = 4;
+  std::vector<std::vector<rmf_traffic::Duration>> durations(num_threads);
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < num_threads; ++t)
+  {
+    threads.emplace_back([&, t]()
+      {
+        for (std::size_t goal : {24, 20, 4})
+        {
+          const auto plan = planner.plan(
+            Planner::Start{start_time, 0, 0.0}, Planner::Goal{goal});
+
+          durations[t].push_back(plan ?
+            plan->get_itinerary().back().trajectory().back().time()
+            - start_time : rmf_traffic::Duration(-1));
+        }
+      });
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+
+  for (std::size_t goal = 0; goal < 3; ++goal)
+  {
+    CHECK(durations[0][goal] > rmf_traffic::Duration(0));
+    for (std::size_t t = 1; t < num_threads; ++t)
+      CHECK(durations[t][goal] == durations[0][goal]);
+  }
+
+  CHECK_THROWS_AS(
+    planner.plan(Planner::Start{start_time, 0, 0.0}, Planner::Goal{25}),
+    std::invalid_argument);
+}
+
+// A ring of waypoints with a spur, so most waypoints can be reached through
+// more than one route. Every waypoint is a holding point, so waiting in place
+// also leads the search back into states that it has already expanded.
+rmf_traffic::agv::Graph make_pruning_test_graph(const std::string& map_name)
+{
+  rmf_traffic::agv::Graph graph;
+  graph.add_waypoint(map_name, { 0, 0}, true); // 0
+  graph.add_waypoint(map_name, {10, 0}, true); // 1
+  graph.add_waypoint(map_name, {10, 10}, true); // 2
+  graph.add_waypoint(map_name, { 0, 10}, true); // 3
+  graph.add_waypoint(map_name, {20, 0}, true); // 4
+
+  auto add_bidir_lane = [&](const std::size_t w0, const std::size_t w1)
+    {
+      graph.add_lane(w0, w1);
+      graph.add_lane(w1, w0);
+    };
+
+  add_bidir_lane(0, 1);
+  add_bidir_lane(1, 2);
+  add_bidir_lane(2, 3);
+  add_bidir_lane(3, 0);
+  add_bidir_lane(1, 4);
+
+  return graph;
+}
+
+rmf_traffic::Time finish_time(const rmf_traffic::agv::Plan& plan)
+{
+  return plan.get_itinerary().back().trajectory().back().time();
+}
+
+// The debugger never prunes any nodes, so it finds the reference solution
+rmf_utils::optional<rmf_traffic::agv::Plan> plan_without_pruning(
+  const rmf_traffic::agv::Planner& planner,
+  const rmf_traffic::agv::Planner::Start& start,
+  const rmf_traffic::agv::Planner::Goal& goal,
+  const rmf_traffic::agv::Planner::Options& options)
+{
+  auto progress =
+    rmf_traffic::agv::Planner::Debug(planner).begin({start}, goal, options);
+
+  rmf_utils::optional<rmf_traffic::agv::Plan> reference;
+  while (progress && !reference)
+    reference = progress.step();
+
+  return reference;
+}
+
+SCENARIO("Planner prunes dominated search nodes", "[pruning]")
+{
+  using Planner = rmf_traffic::agv::Planner;
+
+  const std::string test_map_name = "test_map";
+  const auto graph = make_pruning_test_graph(test_map_name);
+
+  const rmf_traffic::Profile profile = create_test_profile(UnitCircle);
+  const rmf_traffic::agv::VehicleTraits traits(
+    {0.7, 0.3}, {1.0, 0.45}, profile);
+
+  const Planner::Options options{nullptr};
+  const Planner planner{Planner::Configuration{graph, traits}, options};
+
+  const rmf_traffic::Time start_time = std::chrono::steady_clock::now();
+
+  WHEN("The vehicle drives around the ring")
+  {
+    // Both sides of the ring lead to waypoint 2, and the search also tries
+    // holding at each waypoint that it passes, which only reproduces states
+    // that were already reached sooner.
+    const Planner::Start start{start_time, 0, 0.0};
+    const Planner::Goal goal{2};
+
+    const auto plan = planner.plan(start, goal);
+    REQUIRE(plan);
+    CHECK(Planner::Debug::pruned_node_count(plan) > 0);
+
+    const auto reference = plan_without_pruning(planner, start, goal, options);
+    REQUIRE(reference);
+    CHECK(rmf_traffic::time::to_seconds(
+        finish_time(*plan) - finish_time(*reference))
+      == Approx(0.0).margin(1e-6));
+  }
+
+  WHEN("The vehicle must turn around before it leaves")
+  {
+    const Planner::Start start{start_time, 0, M_PI};
+    const Planner::Goal goal{4};
+
+    const auto plan = planner.plan(start, goal);
+    REQUIRE(plan);
+    CHECK(Planner::Debug::pruned_node_count(plan) > 0);
+
+    const auto reference = plan_without_pruning(planner, start, goal, options);
+    REQUIRE(reference);
+    CHECK(rmf_traffic::time::to_seconds(
+        finish_time(*plan) - finish_time(*reference))
+      == Approx(0.0).margin(1e-6));
+
+    // Pruning must not cost us the shortest route, which drives straight
+    // from 0 through 1 to 4 after turning around.
+    const auto& trajectory = plan->get_itinerary().back().trajectory();
+    CHECK((trajectory.back().position().block<2, 1>(0, 0)
+      - Eigen::Vector2d(20, 0)).norm() == Approx(0.0).margin(1e-6));
+  }
+}
+
+SCENARIO("Pruning does not change plans that must wait", "[pruning]")
+{
+  using Planner = rmf_traffic::agv::Planner;
+  using namespace std::chrono_literals;
+
+  const std::string test_map_name = "test_map";
+  const auto graph = make_pruning_test_graph(test_map_name);
+
+  const rmf_traffic::Profile profile = create_test_profile(UnitCircle);
+  const rmf_traffic::agv::VehicleTraits traits(
+    {0.7, 0.3}, {1.0, 0.45}, profile);
+
+  rmf_traffic::schedule::Database database;
+  const auto p_obs = database.register_participant(
+    rmf_traffic::schedule::ParticipantDescription{
+      "obstacle",
+      "test_Planner",
+      rmf_traffic::schedule::ParticipantDescription::Rx::Unresponsive,
+      profile
+    });
+
+  // Another vehicle sits on waypoint 1 for a while. Every route to the goal
+  // passes through waypoint 1, so the plan has to wait for it to leave.
+  const rmf_traffic::Time start_time = std::chrono::steady_clock::now();
+  rmf_traffic::Trajectory obstacle;
+  obstacle.insert(start_time, {10, 0, 0}, {0, 0, 0});
+  obstacle.insert(start_time + 30s, {10, 0, 0}, {0, 0, 0});
+  database.extend(
+    p_obs,
+    {{0, std::make_shared<rmf_traffic::Route>(test_map_name, obstacle)}},
+    0);
+
+  const Planner::Options options{
+    make_test_schedule_validator(database, profile), 5s};
+  const Planner planner{Planner::Configuration{graph, traits}, options};
+
+  const Planner::Start start{start_time, 0, 0.0};
+  const Planner::Goal goal{4};
+
+  const auto plan = planner.plan(start, goal);
+  REQUIRE(plan);
+
+  const auto reference = plan_without_pruning(planner, start, goal, options);
+  REQUIRE(reference);
+
+  const auto straight = rmf_traffic::agv::Interpolate::positions(
+    traits, start_time, {{0, 0, 0}, {20, 0, 0}});
+  CHECK(straight.back().time() < finish_time(*plan));
+  CHECK(rmf_traffic::time::to_seconds(
+      finish_time(*plan) - finish_time(*reference))
+    == Approx(0.0).margin(1e-6));
+}
+
+SCENARIO("Copies of an interrupted plan can resume independently")
+{
+  using Planner = rmf_traffic::agv::Planner;
+
+  const std::string test_map_name = "test_map";
+  rmf_traffic::agv::Graph graph;
+  graph.add_waypoint(test_map_name, { 0, 0}); // 0
+  graph.add_waypoint(test_map_name, {10, 0}); // 1
+  graph.add_waypoint(test_map_name, {10, 10}); // 2
+  graph.add_lane(0, 1);
+  graph.add_lane(1, 2);
+
+  const rmf_traffic::Profile profile = create_test_profile(UnitCircle);
+  const rmf_traffic::agv::VehicleTraits traits(
+    {0.7, 0.3}, {1.0, 0.45}, profile);
+
+  const Planner planner{
+    Planner::Configuration{graph, traits},
+    Planner::Options{nullptr}
+  };
+
+  const rmf_traffic::Time start_time = std::chrono::steady_clock::now();
+  bool interrupt_flag = true;
+
+  rmf_utils::optional<Planner::Result> copy;
+  {
+    auto original = planner.plan(
+      Planner::Start{start_time, 0, 0.0},
+      Planner::Goal{2},
+      Planner::Options{nullptr, Planner::Options::DefaultMinHoldingTime,
+        &interrupt_flag});
+
+    REQUIRE_FALSE(original);
+    CHECK(original.interrupted());
+    copy = original;
+
+    // The original keeps searching on its own after being copied
+    interrupt_flag = false;
+    CHECK(original.resume());
+  }
+
+  // The nodes that the copy queued must outlive the original result
+  REQUIRE(copy->resume());
+  const Eigen::Vector3d finish =
+    (*copy)->get_itinerary().back().trajectory().back().position();
+  CHECK((finish.block<2, 1>(0, 0) - Eigen::Vector2d(10, 10)).norm()
+    == Approx(0.0).margin(1e-6));
+}
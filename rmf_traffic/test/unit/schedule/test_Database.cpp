@@ -17,6 +17,7 @@
 
 #include "utils_Database.hpp"
 #include <rmf_traffic/schedule/Database.hpp>
+#include <rmf_traffic/schedule/Mirror.hpp>
 #include <rmf_traffic/geometry/Box.hpp>
 
 #include "src/rmf_traffic/schedule/debug_Viewer.hpp"
@@ -24,6 +25,9 @@
 
 #include <rmf_utils/catch.hpp>
 
+#include <set>
+#include <tuple>
+
 using namespace std::chrono_literals;
 
 SCENARIO("Test Database Conflicts")
@@ -300,3 +304,892 @@ SCENARIO("Test Database Conflicts")
     }
   }
 }
+
+SCENARIO("Region queries across a large map")
+{
+  using namespace rmf_traffic;
+
+  schedule::Database db;
+  const Time time = std::chrono::steady_clock::now();
+  const Profile profile{geometry::make_final_convex<geometry::Circle>(0.5)};
+
+  // Spread a line of short routes across 200 meters of the map so that they
+  // land in many different spatial cells of the timeline.
+  const std::size_t N = 11;
+  std::vector<schedule::ParticipantId> participants;
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    participants.push_back(db.register_participant(
+        schedule::ParticipantDescription{
+          "participant_" + std::to_string(i),
+          "test_Database",
+          schedule::ParticipantDescription::Rx::Responsive,
+          profile
+        }));
+
+    const double x = 20.0*static_cast<double>(i);
+    Trajectory t;
+    t.insert(time, {x, 0, 0}, {0, 0, 0});
+    t.insert(time + 10s, {x + 2.0, 0, 0}, {0, 0, 0});
+    db.set(participants.back(), create_test_input(0, t), 0);
+  }
+
+  const auto make_region_query = [&](double x, double width)
+    {
+      Eigen::Isometry2d tf = Eigen::Isometry2d::Identity();
+      tf.translate(Eigen::Vector2d{x, 0.0});
+      const auto box = geometry::make_final_convex<geometry::Box>(width, 1.0);
+      auto query = schedule::make_query({});
+      query.spacetime().regions()->push_back(
+        Region("test_map", time, time + 10s, {geometry::Space(box, tf)}));
+      return query;
+    };
+
+  WHEN("Querying a small region in the middle of the map")
+  {
+    const auto view = db.query(make_region_query(101.0, 4.0));
+    REQUIRE(view.size() == 1);
+    CHECK(view.begin()->participant == participants[5]);
+  }
+
+  WHEN("Querying a region that covers the whole map")
+  {
+    const auto view = db.query(make_region_query(100.0, 250.0));
+    CHECK(view.size() == N);
+  }
+
+  WHEN("Querying a region where nothing is scheduled")
+  {
+    const auto view = db.query(make_region_query(110.0, 4.0));
+    CHECK(view.size() == 0);
+  }
+
+  WHEN("A route is moved to a different part of the map")
+  {
+    Trajectory t;
+    t.insert(time, {110.0, 0, 0}, {0, 0, 0});
+    t.insert(time + 10s, {112.0, 0, 0}, {0, 0, 0});
+    db.set(participants[0], create_test_input(1, t), 1);
+
+    const auto moved_view = db.query(make_region_query(110.0, 4.0));
+    REQUIRE(moved_view.size() == 1);
+    CHECK(moved_view.begin()->participant == participants[0]);
+
+    const auto old_view = db.query(make_region_query(1.0, 4.0));
+    CHECK(old_view.size() == 0);
+  }
+}
+
+SCENARIO("Adaptive bucket policy")
+{
+  using namespace rmf_traffic;
+
+  // The fixed database will serve as the ground truth for the adaptive one
+  schedule::Database fixed_db;
+  schedule::Database adaptive_db(
+    schedule::BucketPolicy()
+    .adaptive(true)
+    .merge_threshold(2)
+    .split_threshold(3)
+    .min_bucket_duration(std::chrono::seconds(1)));
+
+  const Time time = std::chrono::steady_clock::now();
+  const Profile profile{geometry::make_final_convex<geometry::Circle>(0.5)};
+
+  const auto add_route = [&](
+    schedule::ParticipantId participant,
+    schedule::ItineraryVersion version,
+    Time start,
+    Duration duration,
+    double x)
+    {
+      Trajectory t;
+      t.insert(start, {x, 0, 0}, {0, 0, 0});
+      t.insert(start + duration, {x + 1.0, 0, 0}, {0, 0, 0});
+      fixed_db.set(participant, create_test_input(version, t), version);
+      adaptive_db.set(participant, create_test_input(version, t), version);
+    };
+
+  std::vector<schedule::ParticipantId> participants;
+  for (std::size_t i = 0; i < 20; ++i)
+  {
+    const schedule::ParticipantDescription description{
+      "participant_" + std::to_string(i),
+      "test_Database",
+      schedule::ParticipantDescription::Rx::Responsive,
+      profile
+    };
+
+    const auto p = fixed_db.register_participant(description);
+    CHECK(adaptive_db.register_participant(description) == p);
+    participants.push_back(p);
+
+    add_route(p, 0, time + std::chrono::seconds(7*i), 20s, 3.0*i);
+  }
+
+  // Routes that are far from everything else in time
+  add_route(participants[0], 1, time + 2h, 30s, 0.0);
+  add_route(participants[1], 1, time - 30min, 30s, 0.0);
+
+  using RouteKey = std::pair<schedule::ParticipantId, RouteId>;
+  const auto get_routes = [](
+    const schedule::Viewer& viewer,
+    const schedule::Query& query)
+    {
+      std::set<RouteKey> routes;
+      for (const auto& element : viewer.query(query))
+        routes.insert({element.participant, element.route_id});
+
+      return routes;
+    };
+
+  const auto check_consistency = [&]()
+    {
+      for (int k = -400; k <= 1500; k += 5)
+      {
+        const Time lower = time + std::chrono::seconds(k);
+        auto query = schedule::query_all();
+        query.spacetime().query_timespan({"test_map"}, lower, lower + 10s);
+        CHECK(get_routes(adaptive_db, query) == get_routes(fixed_db, query));
+      }
+
+      for (int k = 0; k < 20; ++k)
+      {
+        Eigen::Isometry2d tf = Eigen::Isometry2d::Identity();
+        tf.translate(Eigen::Vector2d{3.0*k, 0.0});
+        const auto box = geometry::make_final_convex<geometry::Box>(2.0, 1.0);
+        auto query = schedule::make_query({});
+        query.spacetime().regions()->push_back(
+          Region(
+            "test_map",
+            time + std::chrono::seconds(7*k),
+            time + std::chrono::seconds(7*k + 5),
+            {geometry::Space(box, tf)}));
+
+        CHECK(get_routes(adaptive_db, query) == get_routes(fixed_db, query));
+      }
+    };
+
+  check_consistency();
+
+  WHEN("Routes are erased and the schedule is culled")
+  {
+    for (std::size_t i = 2; i < participants.size(); i += 2)
+    {
+      fixed_db.erase(participants[i], 1);
+      adaptive_db.erase(participants[i], 1);
+    }
+
+    fixed_db.cull(time - 10min);
+    adaptive_db.cull(time - 10min);
+
+    check_consistency();
+    CHECK(get_routes(adaptive_db, schedule::query_all())
+      == get_routes(fixed_db, schedule::query_all()));
+  }
+}
+
+SCENARIO("Invalid bucket policies are rejected")
+{
+  using namespace rmf_traffic;
+  using namespace std::chrono_literals;
+  using Policy = schedule::BucketPolicy;
+
+  CHECK_THROWS_AS(Policy(0s), std::invalid_argument);
+  CHECK_THROWS_AS(Policy(-1s), std::invalid_argument);
+  CHECK_THROWS_AS(Policy().bucket_duration(0s), std::invalid_argument);
+  CHECK_THROWS_AS(Policy().bucket_duration(-5s), std::invalid_argument);
+
+  CHECK_THROWS_AS(Policy().min_bucket_duration(0s), std::invalid_argument);
+  CHECK_THROWS_AS(Policy().min_bucket_duration(-1s), std::invalid_argument);
+  CHECK_THROWS_AS(Policy().max_bucket_duration(0s), std::invalid_argument);
+  CHECK_THROWS_AS(Policy().max_bucket_duration(-1s), std::invalid_argument);
+
+  // The minimum may not exceed the maximum, whichever one is set
+  CHECK_THROWS_AS(
+    Policy().max_bucket_duration(1min).min_bucket_duration(2min),
+    std::invalid_argument);
+  CHECK_THROWS_AS(
+    Policy().min_bucket_duration(1min).max_bucket_duration(30s),
+    std::invalid_argument);
+  CHECK_NOTHROW(Policy().min_bucket_duration(1min).max_bucket_duration(1min));
+
+  // The merge threshold must stay below the split threshold
+  CHECK_THROWS_AS(Policy().split_threshold(16), std::invalid_argument);
+  CHECK_THROWS_AS(Policy().split_threshold(3), std::invalid_argument);
+  CHECK_THROWS_AS(Policy().merge_threshold(256), std::invalid_argument);
+  CHECK_THROWS_AS(Policy().merge_threshold(1000), std::invalid_argument);
+  CHECK_NOTHROW(Policy().merge_threshold(2).split_threshold(3));
+
+  // A rejected value must leave the policy unchanged
+  Policy policy;
+  CHECK_THROWS_AS(policy.merge_threshold(300), std::invalid_argument);
+  CHECK(policy.merge_threshold() == 16);
+  CHECK_THROWS_AS(policy.min_bucket_duration(1h), std::invalid_argument);
+  CHECK(policy.min_bucket_duration() == 5s);
+}
+
+SCENARIO("Heavy route churn")
+{
+  using namespace rmf_traffic;
+
+  schedule::Mirror mirror;
+  schedule::Database db;
+  const Time time = std::chrono::steady_clock::now();
+  const Profile profile{geometry::make_final_convex<geometry::Circle>(0.5)};
+
+  const std::size_t N = 30;
+  std::vector<schedule::ParticipantId> participants;
+  std::vector<double> positions(N, 0.0);
+  std::vector<schedule::ItineraryVersion> versions(N, 0);
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    participants.push_back(db.register_participant(
+        schedule::ParticipantDescription{
+          "participant_" + std::to_string(i),
+          "test_Database",
+          schedule::ParticipantDescription::Rx::Responsive,
+          profile
+        }));
+  }
+
+  // Keep replacing the routes of the participants in an interleaved order so
+  // that entries get removed from all over the timeline buckets.
+  for (std::size_t k = 0; k < 20*N; ++k)
+  {
+    const std::size_t i = (7*k) % N;
+    positions[i] = 5.0*static_cast<double>((3*k) % 40);
+
+    Trajectory t;
+    t.insert(time, {positions[i], 0, 0}, {0, 0, 0});
+    t.insert(time + 30s, {positions[i] + 1.0, 0, 0}, {0, 0, 0});
+    const auto version = versions[i]++;
+    db.set(participants[i], create_test_input(version, t), version);
+
+    if (k % 50 == 0)
+      mirror.update(db.changes(schedule::query_all(), mirror.latest_version()));
+  }
+
+  mirror.update(db.changes(schedule::query_all(), mirror.latest_version()));
+
+  for (const schedule::Viewer* viewer
+    : std::vector<const schedule::Viewer*>{&db, &mirror})
+  {
+    CHECK(viewer->query(schedule::query_all()).size() == N);
+
+    for (std::size_t i = 0; i < N; ++i)
+    {
+      Eigen::Isometry2d tf = Eigen::Isometry2d::Identity();
+      tf.translate(Eigen::Vector2d{positions[i] + 0.5, 0.0});
+      const auto box = geometry::make_final_convex<geometry::Box>(1.0, 1.0);
+      auto region_query = schedule::make_query({});
+      region_query.spacetime().regions()->push_back(
+        Region("test_map", time, time + 30s, {geometry::Space(box, tf)}));
+      region_query.participants() =
+        schedule::Query::Participants::make_only({participants[i]});
+
+      CHECK(viewer->query(region_query).size() == 1);
+    }
+  }
+}
+
+SCENARIO("Snapshots are isolated from later changes")
+{
+  using namespace rmf_traffic;
+
+  // We test the snapshots of a mirror, because the entries of a database
+  // snapshot will still follow the history of their routes forward in time.
+  schedule::Database db;
+  schedule::Mirror mirror;
+  const auto update_mirror = [&]()
+    {
+      mirror.update(
+        db.changes(schedule::query_all(), mirror.latest_version()));
+    };
+
+  const Time time = std::chrono::steady_clock::now();
+  const Profile profile{geometry::make_final_convex<geometry::Circle>(0.5)};
+
+  // Use enough participants that the timeline needs several pages to list all
+  // of its entries.
+  const std::size_t N = 600;
+  std::vector<schedule::ParticipantId> participants;
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    participants.push_back(db.register_participant(
+        schedule::ParticipantDescription{
+          "participant_" + std::to_string(i),
+          "test_Database",
+          schedule::ParticipantDescription::Rx::Responsive,
+          profile
+        }));
+
+    Trajectory t;
+    t.insert(time, {static_cast<double>(i), 0, 0}, {0, 0, 0});
+    t.insert(time + 10s, {static_cast<double>(i), 1, 0}, {0, 0, 0});
+    db.set(participants.back(), create_test_input(0, t), 0);
+  }
+  update_mirror();
+
+  auto timespan_query = schedule::query_all();
+  timespan_query.spacetime().query_timespan({"test_map"}, time, time + 5s);
+
+  const auto first = mirror.snapshot();
+  CHECK(first->query(schedule::query_all()).size() == N);
+  CHECK(first->query(timespan_query).size() == N);
+
+  // Taking another snapshot without any changes in between should give the
+  // same results
+  const auto unchanged = mirror.snapshot();
+  CHECK(unchanged->query(schedule::query_all()).size() == N);
+  CHECK(unchanged->query(timespan_query).size() == N);
+
+  // Erase the routes of the first participants so that entries from the last
+  // page need to be moved into the earlier pages
+  const std::size_t num_erased = 100;
+  for (std::size_t i = 0; i < num_erased; ++i)
+    db.erase(participants[i], 1);
+  update_mirror();
+
+  CHECK(first->query(schedule::query_all()).size() == N);
+  CHECK(first->query(timespan_query).size() == N);
+
+  const auto second = mirror.snapshot();
+  CHECK(second->query(schedule::query_all()).size() == N - num_erased);
+  CHECK(second->query(timespan_query).size() == N - num_erased);
+
+  // Push the remaining routes later in time
+  for (std::size_t i = num_erased; i < N; ++i)
+    db.delay(participants[i], time, 1min, 1);
+  update_mirror();
+
+  CHECK(first->query(timespan_query).size() == N);
+  CHECK(second->query(timespan_query).size() == N - num_erased);
+
+  const auto third = mirror.snapshot();
+  CHECK(third->query(schedule::query_all()).size() == N - num_erased);
+  CHECK(third->query(timespan_query).size() == 0);
+  CHECK(db.snapshot()->query(timespan_query).size() == 0);
+}
+
+SCENARIO("Patches from the change log match patches from a full search")
+{
+  using namespace rmf_traffic;
+
+  // Every database receives the same changes. The first one has no change log,
+  // so its patches always come from a search of the whole timeline. The second
+  // one keeps the default horizon, and the third one has a horizon so short
+  // that its mirrors will sometimes fall behind it.
+  std::vector<std::unique_ptr<schedule::Database>> databases;
+  for (std::size_t i = 0; i < 3; ++i)
+    databases.push_back(std::make_unique<schedule::Database>());
+
+  databases[0]->set_change_log_horizon(0);
+  databases[2]->set_change_log_horizon(5);
+  CHECK(databases[0]->get_change_log_horizon() == 0);
+  CHECK(databases[2]->get_change_log_horizon() == 5);
+
+  const Time time = std::chrono::steady_clock::now();
+  const Profile profile{geometry::make_final_convex<geometry::Circle>(0.5)};
+
+  auto timespan_query = schedule::query_all();
+  timespan_query.spacetime().query_timespan({"test_map"}, time + 12s, time + 60s);
+
+  const auto box = geometry::make_final_convex<geometry::Box>(10.0, 10.0);
+  Eigen::Isometry2d tf = Eigen::Isometry2d::Identity();
+  tf.translate(Eigen::Vector2d{15.0, 0.0});
+  auto region_query = schedule::make_query({});
+  region_query.spacetime().regions()->push_back(
+    Region("test_map", time, time + 40s, {geometry::Space(box, tf)}));
+
+  const std::vector<schedule::Query> queries =
+    {schedule::query_all(), timespan_query, region_query};
+
+  // mirrors[d][q] follows database d through query q
+  std::vector<std::vector<schedule::Mirror>> mirrors(databases.size());
+  for (auto& m : mirrors)
+    m.resize(queries.size());
+
+  const auto update_mirrors = [&]()
+    {
+      for (std::size_t d = 0; d < databases.size(); ++d)
+      {
+        for (std::size_t q = 0; q < queries.size(); ++q)
+        {
+          auto& mirror = mirrors[d][q];
+          const auto after = mirror.latest_version() == 0 ?
+            rmf_utils::nullopt :
+            rmf_utils::optional<schedule::Version>(mirror.latest_version());
+
+          mirror.update(databases[d]->changes(queries[q], after));
+        }
+      }
+    };
+
+  using Contents = std::set<std::tuple<schedule::ParticipantId, RouteId, Time>>;
+  const auto contents = [](const schedule::Viewer& viewer)
+    {
+      Contents output;
+      for (const auto& element : viewer.query(schedule::query_all()))
+      {
+        output.insert(
+          std::make_tuple(
+            element.participant,
+            element.route_id,
+            *element.route.trajectory().finish_time()));
+      }
+
+      return output;
+    };
+
+  const std::size_t N = 10;
+  std::vector<schedule::ParticipantId> participants;
+  std::vector<schedule::ItineraryVersion> versions(N, 0);
+  std::vector<RouteId> next_route(N, 0);
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    for (auto& db : databases)
+    {
+      const auto id = db->register_participant(
+        schedule::ParticipantDescription{
+          "participant_" + std::to_string(i),
+          "test_Database",
+          schedule::ParticipantDescription::Rx::Responsive,
+          profile
+        });
+
+      if (db == databases.front())
+        participants.push_back(id);
+      else
+        CHECK(id == participants.back());
+    }
+  }
+
+  const auto make_input = [&](std::size_t i, std::size_t k)
+    {
+      const double x = 5.0*static_cast<double>((3*k + i) % 8);
+      Trajectory t;
+      t.insert(time, {x, 0, 0}, {0, 0, 0});
+      t.insert(time + 10s, {x + 2.0, 0, 0}, {0, 0, 0});
+      return create_test_input(next_route[i]++, t);
+    };
+
+  for (std::size_t k = 0; k < 40*N; ++k)
+  {
+    const std::size_t i = (7*k) % N;
+    const auto version = versions[i]++;
+    const std::size_t action = (k + k/N) % 5;
+
+    if (action == 0 || action == 3)
+    {
+      const auto input = make_input(i, k);
+      for (auto& db : databases)
+        db->set(participants[i], input, version);
+    }
+    else if (action == 1)
+    {
+      const auto input = make_input(i, k);
+      for (auto& db : databases)
+        db->extend(participants[i], input, version);
+    }
+    else if (action == 2)
+    {
+      const Duration delay = std::chrono::seconds((k % 3) * 4);
+      for (auto& db : databases)
+        db->delay(participants[i], time, delay, version);
+    }
+    else
+    {
+      for (auto& db : databases)
+        db->erase(participants[i], version);
+    }
+
+    // Update the mirrors at an irregular pace so that they sometimes fall
+    // behind the horizon of the short change log.
+    if ((k*k) % 11 < 3)
+      update_mirrors();
+  }
+
+  // Unregister one participant and add a new one in its place
+  for (auto& db : databases)
+  {
+    db->set_current_time(time);
+    db->unregister_participant(participants.front());
+    db->register_participant(
+      schedule::ParticipantDescription{
+        "replacement",
+        "test_Database",
+        schedule::ParticipantDescription::Rx::Responsive,
+        profile
+      });
+  }
+  update_mirrors();
+
+  for (std::size_t q = 0; q < queries.size(); ++q)
+  {
+    const auto expected = contents(mirrors[0][q]);
+    for (std::size_t d = 1; d < databases.size(); ++d)
+      CHECK(contents(mirrors[d][q]) == expected);
+  }
+
+  CHECK(contents(mirrors[0][0]) == contents(*databases[0]));
+  CHECK(contents(mirrors[1][0]) == contents(*databases[1]));
+
+  // Make sure the narrower queries are actually filtering something
+  for (std::size_t q = 1; q < queries.size(); ++q)
+  {
+    const auto filtered = contents(mirrors[1][q]);
+    CHECK(!filtered.empty());
+    CHECK(filtered.size() < contents(mirrors[1][0]).size());
+  }
+}
+
+SCENARIO("Region queries shared between worker threads")
+{
+  using namespace rmf_traffic;
+
+  schedule::Database serial;
+  schedule::Database parallel;
+  parallel.set_query_workers(4);
+  CHECK(serial.get_query_workers() == 1);
+  CHECK(parallel.get_query_workers() == 4);
+
+  const Time time = std::chrono::steady_clock::now();
+  const Profile profile{geometry::make_final_convex<geometry::Circle>(0.5)};
+
+  // Put the participants on a grid so that the regions below will each catch
+  // a different subset of them, with some overlap between the regions.
+  const std::size_t N = 400;
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    const double x = static_cast<double>(i % 20) * 3.0;
+    const double y = static_cast<double>(i / 20) * 3.0;
+    Trajectory t;
+    t.insert(time, {x, y, 0}, {0, 0, 0});
+    t.insert(time + 30s, {x + 2.0, y, 0}, {0, 0, 0});
+
+    for (auto* db : {&serial, &parallel})
+    {
+      const auto id = db->register_participant(
+        schedule::ParticipantDescription{
+          "participant_" + std::to_string(i),
+          "test_Database",
+          schedule::ParticipantDescription::Rx::Responsive,
+          profile
+        });
+
+      db->set(id, create_test_input(0, t), 0);
+    }
+  }
+
+  const auto box = geometry::make_final_convex<geometry::Box>(25.0, 25.0);
+  std::vector<geometry::Space> spaces;
+  for (const auto& p : {Eigen::Vector2d{15, 15}, Eigen::Vector2d{30, 30},
+      Eigen::Vector2d{45, 20}})
+  {
+    Eigen::Isometry2d tf = Eigen::Isometry2d::Identity();
+    tf.translate(p);
+    spaces.emplace_back(box, tf);
+  }
+
+  auto query = schedule::make_query({});
+  query.spacetime().regions()->push_back(
+    Region("test_map", time, time + 30s, spaces));
+
+  using Contents = std::set<std::pair<schedule::ParticipantId, RouteId>>;
+  const auto contents = [](const schedule::Viewer::View& view)
+    {
+      Contents output;
+      for (const auto& element : view)
+        output.insert({element.participant, element.route_id});
+
+      return output;
+    };
+
+  const auto expected = contents(serial.query(query));
+  CHECK(expected.size() > 100);
+  CHECK(expected.size() < N);
+  CHECK(contents(parallel.query(query)) == expected);
+
+  const auto count_additions = [](const schedule::Patch& patch)
+    {
+      std::size_t count = 0;
+      for (const auto& p : patch)
+        count += p.additions().items().size();
+
+      return count;
+    };
+
+  CHECK(count_additions(parallel.changes(query, rmf_utils::nullopt))
+    == expected.size());
+}
+
+SCENARIO("Routes with a long history are only reported once")
+{
+  using namespace rmf_traffic;
+
+  schedule::Database db;
+  const Time time = std::chrono::steady_clock::now();
+  const Profile profile{geometry::make_final_convex<geometry::Circle>(0.5)};
+
+  const std::size_t N = 50;
+  std::vector<schedule::ParticipantId> participants;
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    participants.push_back(db.register_participant(
+        schedule::ParticipantDescription{
+          "participant_" + std::to_string(i),
+          "test_Database",
+          schedule::ParticipantDescription::Rx::Responsive,
+          profile
+        }));
+
+    Trajectory t;
+    t.insert(time, {static_cast<double>(i), 0, 0}, {0, 0, 0});
+    t.insert(time + 10min, {static_cast<double>(i), 1, 0}, {0, 0, 0});
+    db.set(participants.back(), create_test_input(0, t), 0);
+  }
+
+  // Every delay leaves the earlier versions of the route in the timeline, so
+  // each route will be found in many buckets by many of its entries.
+  schedule::ItineraryVersion version = 1;
+  for (std::size_t k = 0; k < 10; ++k, ++version)
+  {
+    for (const auto p : participants)
+      db.delay(p, time, 10s, version);
+  }
+
+  auto timespan_query = schedule::query_all();
+  timespan_query.spacetime().query_timespan({"test_map"}, time, time + 20min);
+
+  CHECK(db.query(schedule::query_all()).size() == N);
+  CHECK(db.query(timespan_query).size() == N);
+
+  // Replace the routes of half of the participants with new routes, so that
+  // the timeline recycles the indices of the routes that were erased.
+  for (std::size_t i = 0; i < N/2; ++i)
+  {
+    db.erase(participants[i], version);
+
+    Trajectory t;
+    t.insert(time, {static_cast<double>(i), 5, 0}, {0, 0, 0});
+    t.insert(time + 10min, {static_cast<double>(i), 6, 0}, {0, 0, 0});
+    db.set(participants[i], create_test_input(1, t), version + 1);
+  }
+
+  CHECK(db.query(schedule::query_all()).size() == N);
+  CHECK(db.query(timespan_query).size() == N);
+  CHECK(db.snapshot()->query(timespan_query).size() == N);
+}
+
+SCENARIO("Single map timespan queries without a Spacetime")
+{
+  using namespace rmf_traffic;
+
+  schedule::Database db;
+  const Time time = std::chrono::steady_clock::now();
+  const Profile profile{geometry::make_final_convex<geometry::Circle>(0.5)};
+
+  const std::size_t N = 40;
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    const auto p = db.register_participant(
+      schedule::ParticipantDescription{
+        "participant_" + std::to_string(i),
+        "test_Database",
+        schedule::ParticipantDescription::Rx::Responsive,
+        profile
+      });
+
+    // Stagger the routes in time and spread them across two maps
+    const Time start = time + std::chrono::seconds(30*i);
+    Trajectory t;
+    t.insert(start, {static_cast<double>(i), 0, 0}, {0, 0, 0});
+    t.insert(start + 1min, {static_cast<double>(i), 1, 0}, {0, 0, 0});
+    db.set(
+      p,
+      {{0, std::make_shared<Route>(i % 2 == 0 ? "map_A" : "map_B", t)}},
+      0);
+  }
+
+  schedule::Mirror mirror;
+  mirror.update(db.changes(schedule::query_all(), rmf_utils::nullopt));
+
+  using Contents = std::set<std::pair<schedule::ParticipantId, RouteId>>;
+  const auto contents = [](const schedule::Viewer::View& view)
+    {
+      Contents output;
+      for (const auto& element : view)
+        output.insert({element.participant, element.route_id});
+
+      return output;
+    };
+
+  const Time lower = time + 3min;
+  const Time upper = time + 8min;
+  auto timespan_query = schedule::query_all();
+  timespan_query.spacetime().query_timespan({"map_A"}, lower, upper);
+
+  const auto snapshot = db.snapshot();
+  for (const schedule::Viewer* viewer
+    : std::vector<const schedule::Viewer*>{&db, &mirror, snapshot.get()})
+  {
+    const auto expected = contents(viewer->query(timespan_query));
+    CHECK(expected.size() > 0);
+    CHECK(expected.size() < N/2);
+    CHECK(contents(viewer->query(
+        "map_A", lower, upper, schedule::Query::Participants::make_all()))
+      == expected);
+
+    CHECK(viewer->query(
+        "map_C", lower, upper,
+        schedule::Query::Participants::make_all()).size() == 0);
+  }
+}
+
+//==============================================================================
+/// A viewer that only implements the functions which every Viewer had to
+/// provide before the single map query() and visit() overloads were added
+class MinimalViewer : public rmf_traffic::schedule::Viewer
+{
+public:
+
+  MinimalViewer(const rmf_traffic::schedule::Viewer& source)
+  : _source(source)
+  {
+    // Do nothing
+  }
+
+  View query(const rmf_traffic::schedule::Query& parameters) const final
+  {
+    return _source.query(parameters);
+  }
+
+  View query(
+    const rmf_traffic::schedule::Query::Spacetime& spacetime,
+    const rmf_traffic::schedule::Query::Participants& participants)
+  const final
+  {
+    return _source.query(spacetime, participants);
+  }
+
+  const std::unordered_set<rmf_traffic::schedule::ParticipantId>&
+  participant_ids() const final
+  {
+    return _source.participant_ids();
+  }
+
+  std::shared_ptr<const rmf_traffic::schedule::ParticipantDescription>
+  get_participant(rmf_traffic::schedule::ParticipantId participant_id)
+  const final
+  {
+    return _source.get_participant(participant_id);
+  }
+
+  rmf_traffic::schedule::Version latest_version() const final
+  {
+    return _source.latest_version();
+  }
+
+private:
+  const rmf_traffic::schedule::Viewer& _source;
+};
+
+SCENARIO("Visiting routes without collecting them into a View")
+{
+  using namespace rmf_traffic;
+
+  schedule::Database db;
+  const Time time = std::chrono::steady_clock::now();
+  const Profile profile{geometry::make_final_convex<geometry::Circle>(0.5)};
+
+  const std::size_t N = 30;
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    const auto p = db.register_participant(
+      schedule::ParticipantDescription{
+        "participant_" + std::to_string(i),
+        "test_Database",
+        schedule::ParticipantDescription::Rx::Responsive,
+        profile
+      });
+
+    Trajectory t;
+    t.insert(time, {static_cast<double>(i), 0, 0}, {0, 0, 0});
+    t.insert(time + 1min, {static_cast<double>(i), 1, 0}, {0, 0, 0});
+    db.set(p, create_test_input(0, t), 0);
+
+    // Delay every route once so that the database timeline holds more than
+    // one entry for each of them
+    db.delay(p, time, 10s, 1);
+  }
+
+  schedule::Mirror mirror;
+  mirror.update(db.changes(schedule::query_all(), rmf_utils::nullopt));
+
+  using Contents = std::set<std::pair<schedule::ParticipantId, RouteId>>;
+  const auto all_query = schedule::query_all();
+  auto timespan_query = schedule::query_all();
+  timespan_query.spacetime().query_timespan({"test_map"}, time, time + 30s);
+
+  const auto snapshot = mirror.snapshot();
+  const MinimalViewer minimal(db);
+  for (const schedule::Viewer* viewer
+    : std::vector<const schedule::Viewer*>{
+      &db, &mirror, snapshot.get(), &minimal})
+  {
+    for (const schedule::Query* query
+      : std::vector<const schedule::Query*>{&all_query, &timespan_query})
+    {
+      Contents expected;
+      for (const auto& element : viewer->query(*query))
+        expected.insert({element.participant, element.route_id});
+
+      CHECK(expected.size() == N);
+
+      Contents visited;
+      CHECK(viewer->visit(
+          query->spacetime(), query->participants(),
+          [&](const schedule::Viewer::View::Element& element) -> bool
+          {
+            CHECK(visited.insert({element.participant, element.route_id})
+            .second);
+            return true;
+          }));
+      CHECK(visited == expected);
+
+      std::size_t count = 0;
+      CHECK_FALSE(viewer->visit(
+          query->spacetime(), query->participants(),
+          [&](const schedule::Viewer::View::Element&) -> bool
+          {
+            return ++count < 5;
+          }));
+      CHECK(count == 5);
+    }
+
+    std::size_t count = 0;
+    CHECK_FALSE(viewer->visit(
+        "test_map", time, time + 30s,
+        schedule::Query::Participants::make_all(),
+        [&](const schedule::Viewer::View::Element&) -> bool
+        {
+          return ++count < 3;
+        }));
+    CHECK(count == 3);
+
+    // Viewers that do not override the single map overloads still get the
+    // same results through the default implementations
+    Contents expected;
+    for (const auto& element : viewer->query(timespan_query))
+      expected.insert({element.participant, element.route_id});
+
+    Contents found;
+    for (const auto& element : viewer->query(
+        "test_map", time, time + 30s,
+        schedule::Query::Participants::make_all()))
+      found.insert({element.participant, element.route_id});
+
+    CHECK(found == expected);
+  }
+}
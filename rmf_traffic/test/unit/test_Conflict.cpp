@@ -19,6 +19,8 @@
 #include "utils_Trajectory.hpp"
 #include "src/rmf_traffic/DetectConflictInternal.hpp"
 
+#include <rmf_traffic/Motion.hpp>
+
 #include <rmf_utils/catch.hpp>
 #include <iostream>
 
@@ -531,6 +533,305 @@ SCENARIO("DetectConflict unit tests")
       CHECK(conflicts.front().a_it == trajectory.find(begin_time + 20s));
     }
   }
+
+  GIVEN("Long trajectories with many segments")
+  {
+    using Statistics = rmf_traffic::DetectConflict::Implementation::Statistics;
+    const auto shape = rmf_traffic::geometry::make_final_convex<
+      rmf_traffic::geometry::Circle>(0.5);
+    const rmf_traffic::Profile profile{shape};
+    const rmf_traffic::Time begin_time = std::chrono::steady_clock::now();
+
+    // Moves parallel to the x axis at a constant speed of 1 m/s
+    const auto make_line = [&](const double x, const double y)
+      {
+        rmf_traffic::Trajectory trajectory;
+        for (std::size_t i = 0; i <= 200; ++i)
+        {
+          trajectory.insert(
+            begin_time + std::chrono::seconds(i),
+            Eigen::Vector3d(x + static_cast<double>(i), y, 0.0),
+            Eigen::Vector3d(1.0, 0.0, 0.0));
+        }
+
+        return trajectory;
+      };
+
+    const auto t1 = make_line(0.0, 0.0);
+
+    WHEN("The trajectories are far apart")
+    {
+      const auto t2 = make_line(0.0, 100.0);
+
+      Statistics statistics;
+      const auto conflict =
+        rmf_traffic::DetectConflict::Implementation::between(
+        profile, t1, profile, t2,
+        rmf_traffic::DetectConflict::Interpolate::CubicSpline,
+        nullptr, &statistics);
+
+      CHECK_FALSE(conflict);
+      CHECK(statistics.trajectory_pairs_pruned == 1);
+      CHECK(statistics.narrowphase_checks == 0);
+    }
+
+    WHEN("The trajectories follow the same path without getting close")
+    {
+      const auto t2 = make_line(20.0, 0.0);
+
+      Statistics statistics;
+      const auto conflict =
+        rmf_traffic::DetectConflict::Implementation::between(
+        profile, t1, profile, t2,
+        rmf_traffic::DetectConflict::Interpolate::CubicSpline,
+        nullptr, &statistics);
+
+      CHECK_FALSE(conflict);
+      CHECK(statistics.trajectory_pairs_pruned == 0);
+      CHECK(statistics.segment_run_pairs_pruned > 0);
+
+      // The routes overlap, but the segments that overlap in space never
+      // overlap in time, so nothing needs to be checked precisely.
+      CHECK(statistics.narrowphase_checks == 0);
+      CHECK_between_is_commutative(profile, t1, profile, t2);
+    }
+
+    WHEN("A trajectory crosses near the end")
+    {
+      rmf_traffic::Trajectory t2;
+      t2.insert(
+        begin_time + 150s, Eigen::Vector3d(180.0, -30.0, 0.0),
+        Eigen::Vector3d(0.0, 1.0, 0.0));
+      t2.insert(
+        begin_time + 210s, Eigen::Vector3d(180.0, 30.0, 0.0),
+        Eigen::Vector3d(0.0, 1.0, 0.0));
+
+      Statistics statistics;
+      std::vector<ConflictData> conflicts;
+      const auto conflict =
+        rmf_traffic::DetectConflict::Implementation::between(
+        profile, t1, profile, t2,
+        rmf_traffic::DetectConflict::Interpolate::CubicSpline,
+        &conflicts, &statistics);
+
+      REQUIRE(conflict);
+      CHECK(rmf_traffic::time::to_seconds(*conflict - begin_time)
+        == Approx(180.0).margin(1.0));
+      REQUIRE_FALSE(conflicts.empty());
+      CHECK(conflicts.front().a_it == t1.find(begin_time + 180s));
+      CHECK(statistics.segment_run_pairs_pruned > 0);
+      CHECK(statistics.narrowphase_checks < 10);
+    }
+  }
+
+  GIVEN("Circular profiles moving along curved trajectories")
+  {
+    using Statistics = rmf_traffic::DetectConflict::Implementation::Statistics;
+    const double radius_a = 0.6;
+    const double radius_b = 0.4;
+    const rmf_traffic::Profile profile_a{
+      rmf_traffic::geometry::make_final_convex<
+        rmf_traffic::geometry::Circle>(radius_a)};
+    const rmf_traffic::Profile profile_b{
+      rmf_traffic::geometry::make_final_convex<
+        rmf_traffic::geometry::Circle>(radius_b)};
+
+    const rmf_traffic::Time begin_time = std::chrono::steady_clock::now();
+
+    rmf_traffic::Trajectory t1;
+    t1.insert(begin_time, {0, 0, 0}, {2, 0, 0});
+    t1.insert(begin_time + 5s, {5, 5, 0}, {0, 2, 0});
+    t1.insert(begin_time + 10s, {0, 10, 0}, {-2, 0, 0});
+
+    rmf_traffic::Trajectory t2;
+    t2.insert(begin_time + 2s, {8, 2, 0}, {-1, 1, 0});
+    t2.insert(begin_time + 5s, {5, 5.5, 0}, {-1.5, 1, 0});
+    t2.insert(begin_time + 9s, {0, 6, 0}, {0, 0, 0});
+
+    // Find the moment of first contact by densely sampling the motions
+    const auto sample_contact = [&](
+      const rmf_traffic::Trajectory& a,
+      const rmf_traffic::Trajectory& b,
+      const double contact)
+      -> rmf_utils::optional<rmf_traffic::Time>
+      {
+        const auto motion_a =
+          rmf_traffic::Motion::compute_cubic_splines(a.begin(), a.end());
+        const auto motion_b =
+          rmf_traffic::Motion::compute_cubic_splines(b.begin(), b.end());
+        const auto start = std::max(*a.start_time(), *b.start_time());
+        const auto finish = std::min(*a.finish_time(), *b.finish_time());
+        for (auto t = start; t <= finish; t += 1ms)
+        {
+          const Eigen::Vector3d d =
+            motion_a->compute_position(t) - motion_b->compute_position(t);
+          if (d.block<2, 1>(0, 0).norm() <= contact)
+            return t;
+        }
+
+        return rmf_utils::nullopt;
+      };
+
+    WHEN("Only circles are involved")
+    {
+      const auto expected = sample_contact(t1, t2, radius_a + radius_b);
+      REQUIRE(expected);
+
+      Statistics statistics;
+      const auto conflict =
+        rmf_traffic::DetectConflict::Implementation::between(
+        profile_a, t1, profile_b, t2,
+        rmf_traffic::DetectConflict::Interpolate::CubicSpline,
+        nullptr, &statistics);
+
+      THEN("The conflict is found precisely without FCL")
+      {
+        REQUIRE(conflict);
+        CHECK(rmf_traffic::time::to_seconds(*conflict - *expected)
+          == Approx(0.0).margin(0.002));
+        CHECK(statistics.analytic_checks > 0);
+        CHECK(statistics.narrowphase_checks == 0);
+        CHECK_between_is_commutative(profile_a, t1, profile_b, t2);
+      }
+    }
+
+    WHEN("The circles just miss each other")
+    {
+      rmf_traffic::Trajectory t3;
+      t3.insert(begin_time, {5, -1.5, 0}, {0, 0, 0});
+      t3.insert(begin_time + 10s, {5, -1.5, 0}, {0, 0, 0});
+
+      // t3 waits just outside of the path that t1 sweeps through
+      Statistics statistics;
+      const auto conflict =
+        rmf_traffic::DetectConflict::Implementation::between(
+        profile_a, t1, profile_b, t3,
+        rmf_traffic::DetectConflict::Interpolate::CubicSpline,
+        nullptr, &statistics);
+
+      CHECK_FALSE(conflict);
+      CHECK(statistics.narrowphase_checks == 0);
+    }
+
+    WHEN("Checking one trajectory against many")
+    {
+      const rmf_traffic::Profile box_profile{
+        rmf_traffic::geometry::make_final_convex<
+          rmf_traffic::geometry::Box>(1.0, 1.0)};
+
+      rmf_traffic::Trajectory far_away;
+      far_away.insert(begin_time, {50, 50, 0}, {0, 0, 0});
+      far_away.insert(begin_time + 10s, {50, 50, 0}, {0, 0, 0});
+
+      rmf_traffic::Trajectory too_late;
+      too_late.insert(begin_time + 20s, {5, 5, 0}, {0, 0, 0});
+      too_late.insert(begin_time + 30s, {5, 5, 0}, {0, 0, 0});
+
+      const std::vector<rmf_traffic::DetectConflict::Other> others = {
+        {&profile_b, &far_away},
+        {&profile_b, &too_late},
+        {&box_profile, &t2},
+        {&profile_b, &t2}
+      };
+
+      const auto conflict = rmf_traffic::DetectConflict::between_many(
+        profile_a, t1, others);
+
+      THEN("The first conflict matches what between() finds")
+      {
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+          CHECK_FALSE(rmf_traffic::DetectConflict::between(
+              profile_a, t1, *others[i].profile, *others[i].trajectory));
+        }
+
+        const auto expected = rmf_traffic::DetectConflict::between(
+          profile_a, t1, box_profile, t2);
+        REQUIRE(expected);
+
+        REQUIRE(conflict);
+        CHECK(conflict->index == 2);
+        CHECK(conflict->time == *expected);
+      }
+
+      THEN("No conflict is found when the others do not conflict")
+      {
+        const std::vector<rmf_traffic::DetectConflict::Other> no_conflicts(
+          others.begin(), others.begin() + 2);
+
+        CHECK_FALSE(rmf_traffic::DetectConflict::between_many(
+            profile_a, t1, no_conflicts));
+      }
+    }
+
+    WHEN("One of the profiles is not a circle")
+    {
+      const rmf_traffic::Profile box_profile{
+        rmf_traffic::geometry::make_final_convex<
+          rmf_traffic::geometry::Box>(1.0, 1.0)};
+
+      Statistics statistics;
+      const auto conflict =
+        rmf_traffic::DetectConflict::Implementation::between(
+        profile_a, t1, box_profile, t2,
+        rmf_traffic::DetectConflict::Interpolate::CubicSpline,
+        nullptr, &statistics);
+
+      THEN("FCL is used to check the conflict")
+      {
+        CHECK(conflict);
+        CHECK(statistics.analytic_checks == 0);
+        CHECK(statistics.narrowphase_checks > 0);
+      }
+    }
+  }
+}
+
+
+SCENARIO("Segment data is cached until the trajectory changes")
+{
+  using rmf_traffic::internal::get_segment_cache;
+
+  const auto time = std::chrono::steady_clock::now();
+  rmf_traffic::Trajectory trajectory;
+  trajectory.insert(time, Eigen::Vector3d(0, 0, 0), Eigen::Vector3d::Zero());
+  trajectory.insert(
+    time + 10s, Eigen::Vector3d(10, 0, 0), Eigen::Vector3d::Zero());
+
+  const auto cache = get_segment_cache(trajectory);
+  REQUIRE(cache->splines.size() == 1);
+  REQUIRE(cache->boxes.size() == 1);
+  CHECK(get_segment_cache(trajectory) == cache);
+
+  WHEN("The trajectory is copied")
+  {
+    const rmf_traffic::Trajectory copy = trajectory;
+
+    THEN("The copy shares the cache")
+    {
+      CHECK(get_segment_cache(copy) == cache);
+    }
+  }
+
+  WHEN("The trajectory is modified")
+  {
+    const rmf_traffic::Trajectory copy = trajectory;
+    trajectory.insert(
+      time + 20s, Eigen::Vector3d(10, 10, 0), Eigen::Vector3d::Zero());
+
+    THEN("The cache is recomputed for the modified trajectory only")
+    {
+      const auto new_cache = get_segment_cache(trajectory);
+      CHECK(new_cache != cache);
+      REQUIRE(new_cache->boxes.size() == 2);
+      CHECK(new_cache->boxes[1].max.y() == Approx(10.0));
+      CHECK(get_segment_cache(copy) == cache);
+
+      trajectory.back().position(Eigen::Vector3d(10, 20, 0));
+      CHECK(rmf_traffic::internal::get_bounding_box(trajectory).max.y()
+        == Approx(20.0));
+    }
+  }
 }
 
 // A useful website for playing with 2D cubic splines: https://www.desmos.com/calculator/
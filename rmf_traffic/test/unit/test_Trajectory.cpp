@@ -150,6 +150,28 @@ SCENARIO("Waypoint Unit Tests")
       }
     }
 
+    WHEN("Rearranging and erasing waypoints")
+    {
+      const rmf_traffic::Trajectory::iterator it_20s =
+        trajectory.find(time + 20s);
+      waypoint.change_time(time + 22s);
+      trajectory.erase(trajectory.begin());
+
+      THEN("References and iterators still refer to the same waypoints")
+      {
+        CHECK(trajectory.size() == 2);
+        CHECK(waypoint.position() == Eigen::Vector3d::Constant(0));
+        CHECK(waypoint.time() == time + 22s);
+        CHECK(it_20s->position() == Eigen::Vector3d::Constant(2));
+        CHECK(&*it_20s == &trajectory.front());
+        CHECK(&waypoint == &trajectory.back());
+        rmf_traffic::Trajectory::iterator next_it = it_20s;
+        CHECK(++next_it == --trajectory.end());
+        CHECK(rmf_traffic::Trajectory::Debug::check_iterator_time_consistency(
+            trajectory, true));
+      }
+    }
+
     WHEN(
       "Positively adjusting all finish times using adjust_finish_times function, using first waypoint")
     {
@@ -818,6 +840,45 @@ SCENARIO("Trajectory and base_iterator unit tests")
       }
     }
 
+    WHEN("Growing a trajectory beyond its inline storage and shrinking it")
+    {
+      rmf_traffic::Trajectory long_trajectory = trajectory;
+      const rmf_traffic::Trajectory::Waypoint& first = long_trajectory.front();
+      for (int i = 3; i < 20; ++i)
+      {
+        long_trajectory.insert(
+          time + i*10s, Eigen::Vector3d::Constant(2*i),
+          Eigen::Vector3d::Constant(2*i+1));
+      }
+
+      const rmf_traffic::Trajectory long_copy = long_trajectory;
+      long_trajectory.erase(
+        long_trajectory.find(time + 10s), long_trajectory.find(time + 180s));
+
+      THEN("Waypoints, references, and copies stay consistent")
+      {
+        CHECK(long_copy.size() == 20);
+        CHECK(long_trajectory.size() == 3);
+        CHECK(&first == &long_trajectory.front());
+        CHECK(first.position() == Eigen::Vector3d::Constant(0));
+        CHECK(long_trajectory.back().position()
+          == Eigen::Vector3d::Constant(38));
+
+        int i = 0;
+        for (const auto& wp : long_copy)
+        {
+          CHECK(wp.time() == time + i*10s);
+          CHECK(wp.position() == Eigen::Vector3d::Constant(2*i));
+          ++i;
+        }
+
+        CHECK(rmf_traffic::Trajectory::Debug::check_iterator_time_consistency(
+            long_trajectory, true));
+        CHECK(rmf_traffic::Trajectory::Debug::check_iterator_time_consistency(
+            long_copy, true));
+      }
+    }
+
     WHEN("Getting the first iterator of empty trajectory")
     {
       THEN("trajectory.end() is returned")
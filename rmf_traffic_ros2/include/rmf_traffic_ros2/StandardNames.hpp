@@ -35,6 +35,8 @@ const std::string RegisterQueryServiceName = Prefix + "register_query";
 const std::string UnregisterQueryServiceName = Prefix + "unregister_query";
 const std::string MirrorUpdateServiceName = Prefix + "mirror_update";
 const std::string MirrorWakeupTopicName = Prefix + "mirror_wakeup";
+// The ID of the registered query gets appended to this topic name
+const std::string MirrorPatchTopicNameBase = Prefix + "mirror_patch_";
 const std::string ScheduleInconsistencyTopicName = Prefix +
   "schedule_inconsistency";
 const std::string ScheduleConflictAckTopicName = Prefix +
@@ -53,6 +55,8 @@ const std::string ScheduleConflictForfeitTopicName = Prefix +
   "schedule_conflict_forfeit";
 const std::string ScheduleConflictConclusionTopicName = Prefix +
   "schedule_conflict_conclusion";
+const std::string ScheduleLockMetricsTopicName = Prefix +
+  "schedule_lock_metrics";
 
 const std::string EmergencyTopicName = "fire_alarm_trigger";
 
@@ -44,9 +44,15 @@ public:
     /// \brief update_on_wakeup
     ///   Specify if the mirror should perform an update whenever it gets woken
     ///   up by the schedule.
+    ///
+    /// \brief update_from_stream
+    ///   Specify if the mirror should apply the patches that the schedule
+    ///   streams out for its query, instead of requesting a patch each time it
+    ///   gets woken up.
     Options(
       std::mutex* update_mutex = nullptr,
-      bool update_on_wakeup = true);
+      bool update_on_wakeup = true,
+      bool update_from_stream = true);
 
     /// Get a reference to the mutex that will be used when performing an
     /// update.
@@ -63,6 +69,18 @@ public:
     /// Toggle the choice to wakeup on an update.
     Options& update_on_wakeup(bool choice);
 
+    /// True if the mirror should be kept up to date using the patches that the
+    /// schedule streams out for the query of this mirror. The mirror_update
+    /// service will only be used when the mirror first starts up, when it
+    /// notices a gap in the stream, or when a MirrorWakeup announces a version
+    /// whose patch does not arrive shortly afterwards.
+    ///
+    /// This only has an effect when update_on_wakeup() is also true.
+    bool update_from_stream() const;
+
+    /// Toggle the choice to update from the patch stream.
+    Options& update_from_stream(bool choice);
+
     class Implementation;
   private:
     rmf_utils::impl_ptr<Implementation> _pimpl;
@@ -20,12 +20,15 @@
 #include <rmf_traffic_ros2/schedule/Patch.hpp>
 #include <rmf_traffic_ros2/schedule/Query.hpp>
 
+#include <rmf_traffic_msgs/msg/mirror_patch.hpp>
 #include <rmf_traffic_msgs/msg/mirror_wakeup.hpp>
 
 #include <rmf_traffic_msgs/srv/mirror_update.hpp>
 #include <rmf_traffic_msgs/srv/register_query.hpp>
 #include <rmf_traffic_msgs/srv/unregister_query.hpp>
 
+#include <rmf_utils/Modular.hpp>
+
 #include <rclcpp/logging.hpp>
 
 namespace rmf_traffic_ros2 {
@@ -41,6 +44,13 @@ using UnregisterQueryClient = rclcpp::Client<UnregisterQuery>::SharedPtr;
 using MirrorWakeup = rmf_traffic_msgs::msg::MirrorWakeup;
 using MirrorWakeupSub = rclcpp::Subscription<MirrorWakeup>::SharedPtr;
 
+using MirrorPatch = rmf_traffic_msgs::msg::MirrorPatch;
+using MirrorPatchSub = rclcpp::Subscription<MirrorPatch>::SharedPtr;
+
+// How long a streaming mirror will wait for the patch that goes with a wakeup
+// before it decides that the patch was lost and asks for an update instead
+const auto StreamGracePeriod = std::chrono::milliseconds(500);
+
 //==============================================================================
 class MirrorManager::Implementation
 {
@@ -51,6 +61,8 @@ public:
   MirrorUpdateClient mirror_update_client;
   UnregisterQueryClient unregister_query_client;
   MirrorWakeupSub mirror_wakeup_sub;
+  MirrorPatchSub mirror_patch_sub;
+  rclcpp::TimerBase::SharedPtr stream_check_timer;
 
   MirrorUpdate::Request::SharedPtr request_msg;
 
@@ -61,6 +73,9 @@ public:
 
   rmf_traffic::schedule::Version next_minimum_version = 0;
 
+  // The latest version that a wakeup has told us about while streaming
+  rmf_traffic::schedule::Version stream_check_version = 0;
+
   Implementation(
     rclcpp::Node& _node,
     Options _options,
@@ -82,12 +97,147 @@ public:
       });
 
     request_msg->query_id = _query_id;
+    configure_stream();
+  }
+
+  bool streaming() const
+  {
+    return options.update_on_wakeup() && options.update_from_stream();
+  }
+
+  void configure_stream()
+  {
+    if (!streaming())
+    {
+      mirror_patch_sub = nullptr;
+      return;
+    }
+
+    if (mirror_patch_sub)
+      return;
+
+    // Every patch in the stream builds on the one before it, so none of them
+    // may be dropped or replaced by a newer one.
+    mirror_patch_sub = node.create_subscription<MirrorPatch>(
+      MirrorPatchTopicNameBase + std::to_string(request_msg->query_id),
+      rclcpp::QoS(rclcpp::KeepAll()).reliable(),
+      [&](const MirrorPatch::SharedPtr msg)
+      {
+        receive_patch(*msg);
+      });
   }
 
   void trigger_wakeup(uint64_t minimum_version)
   {
-    if (options.update_on_wakeup())
+    if (!options.update_on_wakeup())
+      return;
+
+    if (!streaming())
+    {
       update(minimum_version);
+      return;
+    }
+
+    // When we are streaming, the patch for this wakeup should arrive on its
+    // own. We give it a moment to show up, and then check that it did.
+    if (!rmf_utils::modular(mirror->latest_version()).less_than(
+        minimum_version))
+      return;
+
+    if (rmf_utils::modular(stream_check_version).less_than(minimum_version))
+      stream_check_version = minimum_version;
+
+    if (!stream_check_timer)
+    {
+      stream_check_timer = node.create_wall_timer(
+        StreamGracePeriod,
+        [&]()
+        {
+          check_stream();
+        });
+    }
+    else if (stream_check_timer->is_canceled())
+    {
+      stream_check_timer->reset();
+    }
+  }
+
+  void check_stream()
+  {
+    // This timer is only meant to fire once per wakeup
+    stream_check_timer->cancel();
+
+    if (!streaming())
+      return;
+
+    // If a reply is still outstanding, this will only make sure that we catch
+    // up once it arrives.
+    if (rmf_utils::modular(mirror->latest_version()).less_than(
+        stream_check_version))
+      update(stream_check_version);
+  }
+
+  void receive_patch(const MirrorPatch& msg)
+  {
+    if (!streaming())
+      return;
+
+    const uint64_t latest_version = msg.patch.latest_version;
+    if (waiting_for_reply)
+    {
+      // The reply that we are waiting for might be older than this patch, so
+      // we should make sure to catch up once it arrives.
+      if (rmf_utils::modular(next_minimum_version).less_than(latest_version))
+        next_minimum_version = latest_version;
+
+      return;
+    }
+
+    const auto current_version = mirror->latest_version();
+    if (!rmf_utils::modular(current_version).less_than(latest_version))
+    {
+      // We already have everything that this patch could tell us
+      return;
+    }
+
+    if (initial_request || msg.base_version != current_version)
+    {
+      // We have missed part of the stream, so we need to ask for a patch
+      update(latest_version);
+      return;
+    }
+
+    try
+    {
+      apply(convert(msg.patch));
+    }
+    catch (const std::exception& e)
+    {
+      RCLCPP_ERROR(
+        node.get_logger(),
+        "[rmf_traffic_ros2::MirrorManager] Failed to deserialize streamed "
+        "Patch message: " + std::string(e.what()));
+    }
+  }
+
+  void apply(const rmf_traffic::schedule::Patch& patch)
+  {
+    RCLCPP_DEBUG(
+      node.get_logger(),
+      "Updating mirror ["
+      + std::to_string(patch.latest_version())
+      + "]: " + std::to_string(patch.size()) + " changes");
+
+    std::mutex* update_mutex = options.update_mutex();
+    if (update_mutex)
+    {
+      std::lock_guard<std::mutex> lock(*update_mutex);
+      mirror->update(patch);
+    }
+    else
+    {
+      mirror->update(patch);
+    }
   }
 
   void update(
@@ -123,22 +273,7 @@ public:
           const rmf_traffic::schedule::Patch patch =
           convert(response->patch);
 
-          RCLCPP_DEBUG(
-            node.get_logger(),
-            "Updating mirror ["
-            + std::to_string(response->patch.latest_version)
-            + "]: " + std::to_string(patch.size()) + " changes");
-
-          std::mutex* update_mutex = options.update_mutex();
-          if (update_mutex)
-          {
-            std::lock_guard<std::mutex> lock(*update_mutex);
-            mirror->update(patch);
-          }
-          else
-          {
-            mirror->update(patch);
-          }
+          apply(patch);
 
           waiting_for_reply = false;
           if (patch.latest_version() < next_minimum_version)
@@ -185,16 +320,20 @@ public:
 
   bool update_on_wakeup;
 
+  bool update_from_stream;
+
 };
 
 //==============================================================================
 MirrorManager::Options::Options(
   std::mutex* update_mutex,
-  bool update_on_wakeup)
+  bool update_on_wakeup,
+  bool update_from_stream)
 : _pimpl(rmf_utils::make_impl<Implementation>(
       Implementation{
         update_mutex,
-        update_on_wakeup
+        update_on_wakeup,
+        update_from_stream
       }))
 {
   // Do nothing
@@ -226,6 +365,19 @@ auto MirrorManager::Options::update_on_wakeup(bool choice) -> Options&
   return *this;
 }
 
+//==============================================================================
+bool MirrorManager::Options::update_from_stream() const
+{
+  return _pimpl->update_from_stream;
+}
+
+//==============================================================================
+auto MirrorManager::Options::update_from_stream(bool choice) -> Options&
+{
+  _pimpl->update_from_stream = choice;
+  return *this;
+}
+
 //==============================================================================
 const rmf_traffic::schedule::Viewer& MirrorManager::viewer() const
 {
@@ -255,6 +407,7 @@ auto MirrorManager::get_options() const -> const Options&
 MirrorManager& MirrorManager::set_options(Options options)
 {
   _pimpl->options = std::move(options);
+  _pimpl->configure_stream();
   return *this;
 }
 
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "PatchCache.hpp"
+
+namespace rmf_traffic_schedule {
+
+//==============================================================================
+uint64_t PatchCache::add_query(const ScheduleQuery& query)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto& q : _queries)
+  {
+    if (q.second.query == query)
+    {
+      ++q.second.users;
+      return q.first;
+    }
+  }
+
+  const uint64_t key = _next_key++;
+  _queries.insert({key, QueryInfo{query, 1}});
+  return key;
+}
+
+//==============================================================================
+void PatchCache::remove_query(const uint64_t key)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _queries.find(key);
+  if (it == _queries.end())
+    return;
+
+  if (--it->second.users == 0)
+    _queries.erase(it);
+}
+
+//==============================================================================
+auto PatchCache::get(
+  const uint64_t key,
+  const rmf_utils::optional<Version> after,
+  const Version latest,
+  const std::function<SchedulePatch()>& compute) -> ConstPatchPtr
+{
+  const PatchKey patch_key{
+    key, static_cast<bool>(after), after ? *after : 0, latest};
+  std::promise<ConstPatchPtr> promise;
+  std::shared_future<ConstPatchPtr> existing;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (latest != _latest)
+    {
+      // Once the schedule has moved on, nobody will ask for the patches that
+      // were made for the earlier version.
+      _patches.clear();
+      _latest = latest;
+    }
+
+    const auto insertion = _patches.insert(
+      {patch_key, Slot{promise.get_future().share(), &promise}});
+
+    if (!insertion.second)
+      existing = insertion.first->second.patch;
+  }
+
+  if (existing.valid())
+    return existing.get();
+
+  try
+  {
+    auto patch = std::make_shared<const SchedulePatch>(compute());
+    promise.set_value(patch);
+    return patch;
+  }
+  catch (...)
+  {
+    promise.set_exception(std::current_exception());
+
+    // The cache may have been cleared and refilled by other threads while we
+    // were computing, so only remove the slot if it is still ours.
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _patches.find(patch_key);
+    if (it != _patches.end() && it->second.owner == &promise)
+      _patches.erase(it);
+
+    throw;
+  }
+}
+
+} // namespace rmf_traffic_schedule
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TRAFFIC_SCHEDULE__PATCHCACHE_HPP
+#define SRC__RMF_TRAFFIC_SCHEDULE__PATCHCACHE_HPP
+
+#include <rmf_traffic/schedule/Version.hpp>
+
+#include <rmf_traffic_msgs/msg/schedule_patch.hpp>
+#include <rmf_traffic_msgs/msg/schedule_query.hpp>
+
+#include <rmf_utils/optional.hpp>
+
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+
+namespace rmf_traffic_schedule {
+
+//==============================================================================
+/// Many mirrors register identical queries (usually query_all()) and ask for
+/// updates from the same version at the same time. This cache lets all of
+/// those requests share one patch computation and one message conversion.
+class PatchCache
+{
+public:
+
+  using ScheduleQuery = rmf_traffic_msgs::msg::ScheduleQuery;
+  using SchedulePatch = rmf_traffic_msgs::msg::SchedulePatch;
+  using ConstPatchPtr = std::shared_ptr<const SchedulePatch>;
+  using Version = rmf_traffic::schedule::Version;
+
+  /// Get the key for a newly registered query. Identical queries will be
+  /// given the same key.
+  uint64_t add_query(const ScheduleQuery& query);
+
+  /// Release a key that was given by add_query()
+  void remove_query(uint64_t key);
+
+  /// Get the patch for a query key that goes from the version after to the
+  /// version latest. If no such patch has been computed yet, compute will be
+  /// used to make it. If another thread is already computing it, we will
+  /// wait for that thread instead of repeating the work.
+  ConstPatchPtr get(
+    uint64_t key,
+    rmf_utils::optional<Version> after,
+    Version latest,
+    const std::function<SchedulePatch()>& compute);
+
+private:
+
+  struct QueryInfo
+  {
+    ScheduleQuery query;
+    std::size_t users;
+  };
+
+  // (query key, whether there is a base version, base version, latest version)
+  using PatchKey = std::tuple<uint64_t, bool, Version, Version>;
+
+  struct Slot
+  {
+    std::shared_future<ConstPatchPtr> patch;
+
+    // The promise that will fulfill the patch. This lets a thread that failed
+    // to compute its patch make sure that it only removes its own slot.
+    const void* owner;
+  };
+
+  std::mutex _mutex;
+  uint64_t _next_key = 0;
+  std::unordered_map<uint64_t, QueryInfo> _queries;
+  Version _latest = 0;
+  std::map<PatchKey, Slot> _patches;
+};
+
+} // namespace rmf_traffic_schedule
+
+#endif // SRC__RMF_TRAFFIC_SCHEDULE__PATCHCACHE_HPP
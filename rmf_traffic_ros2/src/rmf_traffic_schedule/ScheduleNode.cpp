@@ -29,47 +29,180 @@
 #include <rmf_traffic_ros2/schedule/Inconsistencies.hpp>
 
 #include <rmf_traffic/DetectConflict.hpp>
+#include <rmf_traffic/geometry/Box.hpp>
 #include <rmf_traffic/schedule/Mirror.hpp>
 
 #include <rmf_utils/optional.hpp>
 
+#include <algorithm>
+#include <future>
+#include <map>
 #include <unordered_map>
 
 namespace rmf_traffic_schedule {
 
+//==============================================================================
+/// Make a region of spacetime that contains everything that the trajectory's
+/// profile could touch while it follows the trajectory.
+rmf_traffic::Region make_region(
+  const std::string& map,
+  const rmf_traffic::Profile& profile,
+  const rmf_traffic::Trajectory& trajectory)
+{
+  Eigen::Vector2d min = trajectory.front().position().block<2, 1>(0, 0);
+  Eigen::Vector2d max = min;
+
+  // Each segment is a cubic Hermite spline. Its blending weights for the end
+  // velocities never exceed 4/27, so it can never stray further from the
+  // line between its waypoints than 4/27 of its duration times the speeds at
+  // its ends.
+  auto prev = trajectory.begin();
+  for (auto it = ++trajectory.begin(); it != trajectory.end(); ++it, ++prev)
+  {
+    const auto& wp0 = *prev;
+    const auto& wp1 = *it;
+    const double dt =
+      rmf_traffic::time::to_seconds(wp1.time() - wp0.time());
+
+    const Eigen::Vector2d p0 = wp0.position().block<2, 1>(0, 0);
+    const Eigen::Vector2d p1 = wp1.position().block<2, 1>(0, 0);
+    const Eigen::Vector2d bulge = 4.0/27.0 * dt * (
+      wp0.velocity().block<2, 1>(0, 0).cwiseAbs()
+      + wp1.velocity().block<2, 1>(0, 0).cwiseAbs());
+
+    min = min.cwiseMin(p0.cwiseMin(p1) - bulge);
+    max = max.cwiseMax(p0.cwiseMax(p1) + bulge);
+  }
+
+  double inflation = 0.0;
+  if (const auto& footprint = profile.footprint())
+    inflation = std::max(inflation, footprint->get_characteristic_length());
+
+  if (const auto& vicinity = profile.vicinity())
+    inflation = std::max(inflation, vicinity->get_characteristic_length());
+
+  min -= Eigen::Vector2d::Constant(inflation);
+  max += Eigen::Vector2d::Constant(inflation);
+
+  const Eigen::Vector2d size = max - min;
+  Eigen::Isometry2d tf = Eigen::Isometry2d::Identity();
+  tf.translation() = (min + max)/2.0;
+
+  return rmf_traffic::Region(
+    map,
+    *trajectory.start_time(),
+    *trajectory.finish_time(),
+    {rmf_traffic::geometry::Space(
+        rmf_traffic::geometry::make_final_convex<
+          rmf_traffic::geometry::Box>(size.x(), size.y()),
+        tf)});
+}
+
+//==============================================================================
+/// A route that was added or changed by a patch
+struct Change
+{
+  ScheduleNode::ParticipantId participant;
+  rmf_traffic::ConstRoutePtr route;
+  std::shared_ptr<const rmf_traffic::schedule::ParticipantDescription>
+  description;
+};
+
+//==============================================================================
+/// Get the routes that were changed by a patch. The patch must already have
+/// been applied to the mirror.
+std::vector<Change> get_changes(
+  const rmf_traffic::schedule::Patch& patch,
+  const rmf_traffic::schedule::Mirror& mirror)
+{
+  std::vector<Change> changes;
+  for (const auto& p : patch)
+  {
+    const auto participant = p.participant_id();
+    const auto description = mirror.get_participant(participant);
+    if (!description)
+      continue;
+
+    if (!p.delays().empty())
+    {
+      // A delay changes the existing routes of the participant, so we will
+      // check all of its routes, including any that were just added.
+      const auto itinerary = mirror.get_itinerary(participant);
+      if (!itinerary)
+        continue;
+
+      for (const auto& route : *itinerary)
+        changes.push_back({participant, route, description});
+
+      continue;
+    }
+
+    for (const auto& item : p.additions().items())
+      changes.push_back({participant, item.route, description});
+  }
+
+  return changes;
+}
+
 //==============================================================================
 std::vector<ScheduleNode::ConflictSet> get_conflicts(
-  const rmf_traffic::schedule::Viewer::View& view_changes,
-  const rmf_traffic::schedule::ItineraryViewer& viewer)
+  const std::vector<Change>& changes,
+  const rmf_traffic::schedule::Viewer& viewer,
+  const std::size_t begin,
+  const std::size_t end)
 {
+  using Element = rmf_traffic::schedule::Viewer::View::Element;
+
   std::vector<ScheduleNode::ConflictSet> conflicts;
-  const auto& participants = viewer.participant_ids();
-  for (const auto participant : participants)
+  for (std::size_t i = begin; i < end; ++i)
   {
-    const auto itinerary = *viewer.get_itinerary(participant);
-    const auto& description = *viewer.get_participant(participant);
-    for (auto vc = view_changes.begin(); vc != view_changes.end(); ++vc)
+    const Change& vc = changes[i];
+    if (vc.route->trajectory().size() < 2)
+      continue;
+
+    // Use the spatial index of the viewer to find only the routes that come
+    // near this change while it is active
+    rmf_traffic::schedule::Query::Spacetime spacetime;
+    spacetime.query_regions(
+      {make_region(
+          vc.route->map(),
+          vc.description->profile(),
+          vc.route->trajectory())});
+
+    const auto candidates = viewer.query(
+      spacetime, rmf_traffic::schedule::Query::Participants::make_all());
+
+    // Sort the candidates so that the conflicts always come out in the same
+    // order
+    std::vector<const Element*> ordered;
+    ordered.reserve(candidates.size());
+    for (const auto& candidate : candidates)
     {
-      if (vc->participant == participant)
+      if (candidate.participant == vc.participant)
       {
         // There's no need to check a participant against itself
         continue;
       }
 
-      for (const auto& route : itinerary)
+      ordered.push_back(&candidate);
+    }
+
+    std::sort(ordered.begin(), ordered.end(),
+      [](const Element* a, const Element* b)
       {
-        assert(route);
-        if (route->map() != vc->route.map())
-          continue;
+        return std::make_pair(a->participant, a->route_id)
+        < std::make_pair(b->participant, b->route_id);
+      });
 
-        if (rmf_traffic::DetectConflict::between(
-            vc->description.profile(),
-            vc->route.trajectory(),
-            description.profile(),
-            route->trajectory()))
-        {
-          conflicts.push_back({participant, vc->participant});
-        }
+    for (const Element* candidate : ordered)
+    {
+      if (rmf_traffic::DetectConflict::between(
+          vc.description->profile(),
+          vc.route->trajectory(),
+          candidate->description.profile(),
+          candidate->route.trajectory()))
+      {
+        conflicts.push_back({candidate->participant, vc.participant});
       }
     }
   }
@@ -77,6 +210,95 @@ std::vector<ScheduleNode::ConflictSet> get_conflicts(
   return conflicts;
 }
 
+//==============================================================================
+std::vector<ScheduleNode::ConflictSet> get_conflicts(
+  const std::vector<Change>& changes,
+  const rmf_traffic::schedule::Viewer& viewer,
+  const std::size_t num_workers)
+{
+  const std::size_t num_shards =
+    std::max<std::size_t>(1, std::min(num_workers, changes.size()));
+  const std::size_t shard_size =
+    (changes.size() + num_shards - 1) / num_shards;
+
+  // Every shard after the first is handed off to a worker thread. The viewer
+  // and the changes are only read from while the workers are running.
+  std::vector<std::future<std::vector<ScheduleNode::ConflictSet>>> shards;
+  for (std::size_t begin = shard_size; begin < changes.size();
+    begin += shard_size)
+  {
+    const std::size_t end = std::min(begin + shard_size, changes.size());
+    shards.emplace_back(
+      std::async(
+        std::launch::async,
+        [&changes, &viewer, begin, end]()
+        {
+          return get_conflicts(changes, viewer, begin, end);
+        }));
+  }
+
+  // This thread takes care of the first shard itself
+  auto conflicts = get_conflicts(
+    changes, viewer, 0, std::min(shard_size, changes.size()));
+
+  // Merge the results in the order of the shards so that the outcome is the
+  // same as checking everything on one thread.
+  for (auto& shard : shards)
+  {
+    const auto shard_conflicts = shard.get();
+    conflicts.insert(
+      conflicts.end(), shard_conflicts.begin(), shard_conflicts.end());
+  }
+
+  return conflicts;
+}
+
+//==============================================================================
+/// Keeps track of how long the conflict checker holds the database lock, and
+/// periodically publishes a summary of it.
+class LockMetrics
+{
+public:
+
+  using Duration = std::chrono::steady_clock::duration;
+  using Msg = rmf_traffic_msgs::msg::ScheduleLockMetrics;
+
+  void record(const Duration hold_time)
+  {
+    ++_samples;
+    _total += hold_time;
+    _max = std::max(_max, hold_time);
+  }
+
+  void publish_if_ready(rclcpp::Publisher<Msg>& publisher)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    if (now - _last_report < std::chrono::seconds(1) || _samples == 0)
+      return;
+
+    Msg msg;
+    msg.samples = _samples;
+    msg.mean_hold_time =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+      _total / _samples).count();
+    msg.max_hold_time =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(_max).count();
+    publisher.publish(msg);
+
+    _samples = 0;
+    _total = Duration(0);
+    _max = Duration(0);
+    _last_report = now;
+  }
+
+private:
+  uint64_t _samples = 0;
+  Duration _total = Duration(0);
+  Duration _max = Duration(0);
+  std::chrono::steady_clock::time_point _last_report =
+    std::chrono::steady_clock::now();
+};
+
 //==============================================================================
 ScheduleNode::ScheduleNode()
 : Node("rmf_traffic_schedule_node"),
@@ -223,6 +445,24 @@ ScheduleNode::ScheduleNode()
   conflict_conclusion_pub = create_publisher<ConflictConclusion>(
     rmf_traffic_ros2::ScheduleConflictConclusionTopicName, negotiation_qos);
 
+  schedule_lock_metrics_pub = create_publisher<ScheduleLockMetrics>(
+    rmf_traffic_ros2::ScheduleLockMetricsTopicName,
+    rclcpp::SystemDefaultsQoS());
+
+  const std::size_t default_conflict_check_workers =
+    std::max(1u, std::thread::hardware_concurrency());
+  conflict_check_workers = static_cast<std::size_t>(
+    std::max<int64_t>(1, declare_parameter<int64_t>(
+      "conflict_check_workers", default_conflict_check_workers)));
+
+  patch_publish_quit = false;
+  patch_publish_thread = std::thread(
+    [&]()
+    {
+      while (rclcpp::ok() && !patch_publish_quit)
+        publish_patches();
+    });
+
   conflict_check_quit = false;
   conflict_check_thread = std::thread(
     [&]()
@@ -231,12 +471,16 @@ ScheduleNode::ScheduleNode()
       const auto query_all = rmf_traffic::schedule::query_all();
       Version last_checked_version = 0;
 
+      LockMetrics lock_metrics;
+
       while (rclcpp::ok() && !conflict_check_quit)
       {
         rmf_utils::optional<rmf_traffic::schedule::Patch> next_patch;
-        rmf_traffic::schedule::Viewer::View view_changes;
 
-        // Use this scope to minimize how long we lock the database for
+        // Use this scope to minimize how long we lock the database for. The
+        // patch is the only thing that we need from the database. It holds
+        // its own copies of the route pointers, so the mirror can be updated
+        // from it after the lock has been released.
         {
           std::unique_lock<std::mutex> lock(database_mutex);
           conflict_check_cv.wait_for(lock, std::chrono::milliseconds(100), [&]()
@@ -252,24 +496,30 @@ ScheduleNode::ScheduleNode()
             continue;
           }
 
+          const auto lock_start = std::chrono::steady_clock::now();
           next_patch = database->changes(query_all, last_checked_version);
+          lock.unlock();
 
-          // TODO(MXG): Check whether the database really needs to remain locked
-          // during this update.
-          try
-          {
-            mirror.update(*next_patch);
-            view_changes = database->query(query_all, last_checked_version);
-            last_checked_version = next_patch->latest_version();
-          }
-          catch (const std::exception& e)
-          {
-            RCLCPP_ERROR(get_logger(), e.what());
-            continue;
-          }
+          lock_metrics.record(std::chrono::steady_clock::now() - lock_start);
+        }
+
+        lock_metrics.publish_if_ready(*schedule_lock_metrics_pub);
+
+        std::vector<Change> changes;
+        try
+        {
+          mirror.update(*next_patch);
+          changes = get_changes(*next_patch, mirror);
+          last_checked_version = next_patch->latest_version();
+        }
+        catch (const std::exception& e)
+        {
+          RCLCPP_ERROR(get_logger(), e.what());
+          continue;
         }
 
-        const auto conflicts = get_conflicts(view_changes, mirror);
+        const auto conflicts =
+          get_conflicts(changes, mirror, conflict_check_workers);
         std::unordered_map<Version, const Negotiation*> new_negotiations;
         for (const auto& conflict : conflicts)
         {
@@ -301,6 +551,11 @@ ScheduleNode::~ScheduleNode()
   conflict_check_quit = true;
   if (conflict_check_thread.joinable())
     conflict_check_thread.join();
+
+  patch_publish_quit = true;
+  patch_publish_cv.notify_all();
+  if (patch_publish_thread.joinable())
+    patch_publish_thread.join();
 }
 
 //==============================================================================
@@ -330,6 +585,18 @@ void ScheduleNode::register_query(
   last_query_id = query_id;
   registered_queries.insert(
     std::make_pair(query_id, rmf_traffic_ros2::convert(request->query)));
+  query_patch_keys[query_id] = patch_cache.add_query(request->query);
+  {
+    std::unique_lock<std::mutex> lock(database_mutex);
+    patch_streams[query_id] = PatchStream{
+      create_publisher<MirrorPatch>(
+        rmf_traffic_ros2::MirrorPatchTopicNameBase + std::to_string(query_id),
+        rclcpp::QoS(rclcpp::KeepAll()).reliable()),
+      registered_queries.at(query_id),
+      query_patch_keys.at(query_id),
+      database->latest_version()
+    };
+  }
 
   response->query_id = query_id;
   RCLCPP_INFO(
@@ -357,6 +624,18 @@ void ScheduleNode::unregister_query(
   }
 
   registered_queries.erase(it);
+  const auto key_it = query_patch_keys.find(request->query_id);
+  if (key_it != query_patch_keys.end())
+  {
+    patch_cache.remove_query(key_it->second);
+    query_patch_keys.erase(key_it);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(database_mutex);
+    patch_streams.erase(request->query_id);
+  }
+
   response->confirmation = true;
 
   RCLCPP_INFO(
@@ -462,8 +741,17 @@ void ScheduleNode::mirror_update(
   if (!request->initial_request)
     version = request->latest_mirror_version;
 
-  response->patch =
-    rmf_traffic_ros2::convert(database->changes(query_it->second, version));
+  // Mirrors with identical queries that are at the same version will share
+  // the same patch, so we only compute and convert it once.
+  const rmf_traffic::schedule::Query& query = query_it->second;
+  response->patch = *patch_cache.get(
+    query_patch_keys.at(request->query_id),
+    version,
+    database->latest_version(),
+    [&]()
+    {
+      return rmf_traffic_ros2::convert(database->changes(query, version));
+    });
 }
 
 //==============================================================================
@@ -571,9 +859,91 @@ void ScheduleNode::wakeup_mirrors()
   msg.latest_version = database->latest_version();
   mirror_wakeup_publisher->publish(msg);
 
+  patch_publish_cv.notify_all();
   conflict_check_cv.notify_all();
 }
 
+//==============================================================================
+void ScheduleNode::publish_patches()
+{
+  struct Outgoing
+  {
+    MirrorPatchPublisher::SharedPtr publisher;
+    uint64_t patch_key;
+    Version base;
+    const rmf_traffic::schedule::Patch* patch;
+  };
+
+  // Streams with identical queries that are at the same version will share
+  // one patch
+  std::map<std::pair<uint64_t, Version>, rmf_traffic::schedule::Patch> patches;
+  std::vector<Outgoing> outgoing;
+  Version latest;
+
+  // The database can only be read while it is locked, so this is where the
+  // patches get computed. Converting them into messages and publishing them
+  // happens after the lock has been released.
+  {
+    std::unique_lock<std::mutex> lock(database_mutex);
+    patch_publish_cv.wait_for(lock, std::chrono::milliseconds(100), [&]()
+    {
+      return database->latest_version() != patches_published_version
+      || patch_publish_quit;
+    });
+
+    latest = database->latest_version();
+    if (latest == patches_published_version || patch_publish_quit)
+    {
+      // This is a casual wakeup to check if we're supposed to quit yet
+      return;
+    }
+
+    patches_published_version = latest;
+    for (auto& s : patch_streams)
+    {
+      PatchStream& stream = s.second;
+      const Version base = stream.last_version;
+      if (base == latest)
+        continue;
+
+      stream.last_version = latest;
+
+      // There is no point computing a patch that nobody is listening for. If a
+      // mirror subscribes later, it will notice the gap and use the
+      // mirror_update service to catch up.
+      if (stream.publisher->get_subscription_count() == 0)
+        continue;
+
+      const auto patch_id = std::make_pair(stream.patch_key, base);
+      auto patch_it = patches.find(patch_id);
+      if (patch_it == patches.end())
+      {
+        patch_it = patches.insert(
+          {patch_id, database->changes(stream.query, base)}).first;
+      }
+
+      outgoing.push_back(
+        {stream.publisher, stream.patch_key, base, &patch_it->second});
+    }
+  }
+
+  for (const auto& o : outgoing)
+  {
+    MirrorPatch patch_msg;
+    patch_msg.base_version = o.base;
+    patch_msg.patch = *patch_cache.get(
+      o.patch_key,
+      o.base,
+      latest,
+      [&]()
+      {
+        return rmf_traffic_ros2::convert(*o.patch);
+      });
+
+    o.publisher->publish(patch_msg);
+  }
+}
+
 //==============================================================================
 void print_conclusion(
   const std::unordered_map<
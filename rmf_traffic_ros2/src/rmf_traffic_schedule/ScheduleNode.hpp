@@ -18,6 +18,8 @@
 #ifndef SRC__RMF_TRAFFIC_SCHEDULE__SCHEDULENODE_HPP
 #define SRC__RMF_TRAFFIC_SCHEDULE__SCHEDULENODE_HPP
 
+#include "PatchCache.hpp"
+
 #include "../rmf_traffic_ros2/schedule/NegotiationRoom.hpp"
 
 #include <rmf_traffic/schedule/Database.hpp>
@@ -25,6 +27,7 @@
 
 #include <rclcpp/node.hpp>
 
+#include <rmf_traffic_msgs/msg/mirror_patch.hpp>
 #include <rmf_traffic_msgs/msg/mirror_wakeup.hpp>
 
 #include <rmf_traffic_msgs/msg/itinerary_clear.hpp>
@@ -43,6 +46,7 @@
 #include <rmf_traffic_msgs/msg/schedule_conflict_conclusion.hpp>
 
 #include <rmf_traffic_msgs/msg/schedule_inconsistency.hpp>
+#include <rmf_traffic_msgs/msg/schedule_lock_metrics.hpp>
 
 #include <rmf_traffic_msgs/srv/mirror_update.hpp>
 #include <rmf_traffic_msgs/srv/register_query.hpp>
@@ -55,6 +59,7 @@
 
 #include <rmf_utils/Modular.hpp>
 
+#include <mutex>
 #include <set>
 #include <unordered_map>
 
@@ -130,6 +135,13 @@ public:
   using MirrorWakeupPublisher = rclcpp::Publisher<MirrorWakeup>;
   MirrorWakeupPublisher::SharedPtr mirror_wakeup_publisher;
 
+  using MirrorPatch = rmf_traffic_msgs::msg::MirrorPatch;
+  using MirrorPatchPublisher = rclcpp::Publisher<MirrorPatch>;
+
+  /// Wait until the schedule changes and then publish a patch to every stream
+  /// that is behind. This gets called repeatedly by the patch_publish_thread.
+  void publish_patches();
+
   using ItinerarySet = rmf_traffic_msgs::msg::ItinerarySet;
   void itinerary_set(const ItinerarySet& set);
   rclcpp::Subscription<ItinerarySet>::SharedPtr itinerary_set_sub;
@@ -167,11 +179,51 @@ public:
   std::size_t last_query_id = 0;
   QueryMap registered_queries;
 
+  // Lets mirrors with identical queries share their patches
+  PatchCache patch_cache;
+
+  // Maps the ID of each registered query to its key in the patch_cache
+  std::unordered_map<uint64_t, uint64_t> query_patch_keys;
+
+  // Each registered query has a topic that its mirrors can listen to for
+  // patches, so they do not need to call the mirror_update service every time
+  // the schedule changes.
+  struct PatchStream
+  {
+    MirrorPatchPublisher::SharedPtr publisher;
+
+    // Copies of the registered query and its patch_cache key, so that the
+    // patch_publish_thread does not need to look at registered_queries
+    rmf_traffic::schedule::Query query;
+    uint64_t patch_key;
+
+    // The patches of this stream form an unbroken chain, so each one begins at
+    // the version where the previous one ended.
+    rmf_traffic::schedule::Version last_version;
+  };
+  std::unordered_map<uint64_t, PatchStream> patch_streams;
+
+  // The patches get computed and published by their own thread, so the
+  // itinerary callbacks never need to wait for them while they hold the
+  // database lock.
+  std::thread patch_publish_thread;
+  std::condition_variable patch_publish_cv;
+  std::atomic_bool patch_publish_quit;
+  rmf_traffic::schedule::Version patches_published_version = 0;
+
   // TODO(MXG): Make this a separate node
   std::thread conflict_check_thread;
   std::condition_variable conflict_check_cv;
   std::atomic_bool conflict_check_quit;
 
+  // The number of threads that will share the work of checking a patch for
+  // conflicts. This is set by the "conflict_check_workers" parameter.
+  std::size_t conflict_check_workers;
+
+  using ScheduleLockMetrics = rmf_traffic_msgs::msg::ScheduleLockMetrics;
+  using ScheduleLockMetricsPub = rclcpp::Publisher<ScheduleLockMetrics>;
+  ScheduleLockMetricsPub::SharedPtr schedule_lock_metrics_pub;
+
   using ConflictAck = rmf_traffic_msgs::msg::ScheduleConflictAck;
   using ConflictAckSub = rclcpp::Subscription<ConflictAck>;
   ConflictAckSub::SharedPtr conflict_ack_sub;